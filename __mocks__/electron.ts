@@ -1,4 +1,5 @@
 export const ipcRenderer = {
     on: jest.fn(),
     removeListener: jest.fn(),
+    send: jest.fn(),
 }
\ No newline at end of file
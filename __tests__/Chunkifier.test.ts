@@ -66,5 +66,18 @@ describe(PlasticityDocument, () => {
         const chunkifier = new Chunkifier('plasticity', 1, before.json, before.c3d);
         const data = chunkifier.serialize();
         const after = Chunkifier.load(data);
+        expect(after.c3d).toEqual(before.c3d);
+        expect(after.tessellation).toBeUndefined();
+    });
+
+    test("serialize & deserialize tessellation", async () => {
+        const save = new PlasticityDocument(originator);
+        const filename = path.join(dir, 'test2.plasticity');
+        const before = await save.serialize(filename);
+        const tessellation = await db.serializeTessellation();
+        const chunkifier = new Chunkifier('plasticity', 1, before.json, before.c3d, tessellation);
+        const after = Chunkifier.load(chunkifier.serialize());
+        expect(after.c3d).toEqual(before.c3d);
+        expect(after.tessellation).toEqual(tessellation);
     });
 })
\ No newline at end of file
@@ -0,0 +1,23 @@
+import c3d from '../build/Release/c3d.node';
+import './matchers';
+
+test("intersecting curves whose bounding boxes overlap", async () => {
+    const segment = (x1: number, y1: number, x2: number, y2: number) =>
+        new c3d.LineSegment3D(new c3d.CartPoint3D(x1, y1, 0), new c3d.CartPoint3D(x2, y2, 0));
+    const curves = [segment(0, 0, 2, 2)];
+    const others = [segment(0, 2, 2, 0), segment(10, 10, 11, 11), segment(0, 1, 2, 1)];
+
+    const { pairs, params } = await c3d.CurveIntersection.Intersect_async(curves, others, 10e-3);
+    expect([...pairs]).toEqual([0, 1, 0, 3]);
+    for (let i = 0; i < pairs.length / 2; i++) {
+        const all = [...curves, ...others];
+        const p1 = all[pairs[2 * i]].PointOn(params[2 * i]);
+        const p2 = all[pairs[2 * i + 1]].PointOn(params[2 * i + 1]);
+        expect(p1.x).toBeCloseTo(p2.x);
+        expect(p1.y).toBeCloseTo(p2.y);
+    }
+
+    // Others aren't intersected with one another, but new curves are
+    const { pairs: among } = c3d.CurveIntersection.Intersect([...curves, others[0]], others.slice(1), 10e-3);
+    expect([...among]).toEqual([0, 1, 0, 3, 1, 3]);
+});
@@ -1,17 +1,38 @@
 import c3d from '../build/Release/c3d.node';
 import './matchers';
 
-test("basic meshification of solids", () => {
+const names = new c3d.SNameMaker(c3d.CreatorType.ElementarySolid, c3d.ESides.SideNone, 0);
+const stepData = new c3d.StepData(c3d.StepType.SpaceStep, 0.003);
+const note = new c3d.FormNote(true, true, true, false, false);
+
+function makeBox() {
+    const points = [
+        new c3d.CartPoint3D(0, 0, 0),
+        new c3d.CartPoint3D(1, 0, 0),
+        new c3d.CartPoint3D(1, 1, 0),
+        new c3d.CartPoint3D(1, 1, 1),
+    ];
+    return c3d.ActionSolid.ElementarySolid(points, c3d.ElementaryShellType.Block, names);
+}
+
+function makeSphere() {
     const points = [
         new c3d.CartPoint3D(0, 0, 0),
         new c3d.CartPoint3D(0, 0, 1),
         new c3d.CartPoint3D(1, 0, 0),
     ];
-    const names = new c3d.SNameMaker(c3d.CreatorType.ElementarySolid, c3d.ESides.SideNone, 0);
-    const sphere = c3d.ActionSolid.ElementarySolid(points, c3d.ElementaryShellType.Sphere, names);
+    return c3d.ActionSolid.ElementarySolid(points, c3d.ElementaryShellType.Sphere, names);
+}
+
+let box: c3d.Solid;
+let sphere: c3d.Solid;
 
-    const stepData = new c3d.StepData(c3d.StepType.SpaceStep, 0.003);
-    const note = new c3d.FormNote(true, true, true, false, false);
+beforeEach(() => {
+    box = makeBox();
+    sphere = makeSphere();
+})
+
+test("basic meshification of solids", () => {
     const item = sphere.CreateMesh(stepData, note);
     const mesh = item.Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
 
@@ -22,4 +43,462 @@ test("basic meshification of solids", () => {
     // want to render them.
     const edges = mesh.GetEdges(true);
     expect(edges.length).toBe(0);
-})
\ No newline at end of file
+})
+
+test("parallel tessellation of solids", async () => {
+    const { faces, edges } = await box.TessellateParallel_async(stepData, note, true);
+    expect(faces.length).toBe(6);
+    expect(edges.length).toBe(12);
+    for (const [i, face] of faces.entries()) {
+        expect(face.i).toBe(i);
+        expect(face.index.length).toBeGreaterThan(0);
+        expect(face.position.length).toBe(face.normal.length);
+    }
+    for (const [i, edge] of edges.entries()) {
+        expect(edge.i).toBe(i);
+        expect(edge.position.length).toBeGreaterThan(0);
+    }
+})
+
+test("packed meshification of solids", () => {
+    const mesh = box.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+
+    const grids = mesh.GetBuffers();
+    const { index, position, normal, groups } = mesh.GetPackedBuffers();
+    expect(groups.length).toBe(5 * grids.length);
+    expect(index).toBeInstanceOf(Uint16Array);
+    for (const grid of grids) expect(grid.index).toBeInstanceOf(Uint16Array);
+    expect(index.buffer).toBe(position.buffer);
+
+    let pointOffset = 0;
+    for (const [g, grid] of grids.entries()) {
+        const [start, count, i, style, simpleName] = groups.subarray(5 * g, 5 * g + 5);
+        expect(count).toBe(grid.index.length);
+        expect(i).toBe(grid.i);
+        expect(style).toBe(grid.style);
+        expect(simpleName).toBe(grid.simpleName);
+        expect(index.subarray(start, start + count)).toEqual(grid.index.map(j => j + pointOffset));
+        expect(position.subarray(3 * pointOffset, 3 * pointOffset + grid.position.length)).toEqual(grid.position);
+        expect(normal.subarray(3 * pointOffset, 3 * pointOffset + grid.normal.length)).toEqual(grid.normal);
+        pointOffset += grid.position.length / 3;
+    }
+})
+
+test("packing the buffers of a tessellation", async () => {
+    const { faces } = await box.TessellateParallel_async(stepData, note, true);
+
+    const { index, position, groups } = c3d.MeshBufferPool.Pack(faces);
+    expect(groups.length).toBe(5 * faces.length);
+    let pointOffset = 0;
+    for (const [g, face] of faces.entries()) {
+        const [start, count, i, style, simpleName] = groups.subarray(5 * g, 5 * g + 5);
+        expect([count, i, style, simpleName]).toEqual([face.index.length, face.i, face.style, face.simpleName]);
+        expect(index.subarray(start, start + count)).toEqual(face.index.map(j => j + pointOffset));
+        expect(position.subarray(3 * pointOffset, 3 * pointOffset + face.position.length)).toEqual(face.position);
+        pointOffset += face.position.length / 3;
+    }
+    const reversed = c3d.MeshBufferPool.Pack([...faces].reverse());
+    expect(reversed.groups[2]).toBe(faces[faces.length - 1].i);
+    expect(() => c3d.MeshBufferPool.Pack([{ ...faces[0], grid: undefined } as any])).toThrow();
+})
+
+test("packed edges of solids", () => {
+    const mesh = box.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+
+    const edges = mesh.GetEdges(true);
+    const { position, offsets, simpleNames } = mesh.GetPackedEdges(true);
+    expect(offsets.length).toBe(edges.length + 1);
+    expect(simpleNames.length).toBe(edges.length);
+    expect(position.buffer).toBe(offsets.buffer);
+    for (const [k, edge] of edges.entries()) {
+        expect(simpleNames[k]).toBe(edge.simpleName);
+        expect(position.subarray(3 * offsets[k], 3 * offsets[k + 1])).toEqual(edge.position);
+    }
+    expect(mesh.GetApexes().length % 3).toBe(0);
+});
+
+test("quantized meshification of solids", () => {
+    const mesh = box.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+
+    const grids = mesh.GetBuffers();
+    const quantized = mesh.GetQuantizedBuffers();
+    expect(quantized.length).toBe(grids.length);
+    for (const [g, grid] of grids.entries()) {
+        const { index, position, normal, offset, scale, i } = quantized[g];
+        expect(i).toBe(grid.i);
+        expect(index).toEqual(grid.index);
+        for (let j = 0; j < position.length; j++) {
+            const c = j % 3;
+            expect(offset[c] + scale[c] * position[j] / 65535).toBeCloseTo(grid.position[j], 4);
+        }
+        for (let j = 0; j < normal.length / 2; j++) {
+            let x = normal[2 * j] / 32767, y = normal[2 * j + 1] / 32767;
+            const z = 1 - Math.abs(x) - Math.abs(y);
+            if (z < 0) [x, y] = [(1 - Math.abs(y)) * Math.sign(x), (1 - Math.abs(x)) * Math.sign(y)];
+            const l = Math.hypot(x, y, z);
+            expect(x / l).toBeCloseTo(grid.normal[3 * j + 0], 3);
+            expect(y / l).toBeCloseTo(grid.normal[3 * j + 1], 3);
+            expect(z / l).toBeCloseTo(grid.normal[3 * j + 2], 3);
+        }
+    }
+});
+
+test("tessellation cache", async () => {
+    const copy = box.Duplicate().Cast<c3d.Solid>(c3d.SpaceType.Solid);
+    c3d.TessellationCache.Clear();
+
+    const first = await box.TessellateParallel_async(stepData, note, true, true);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 0, misses: 6, entries: 6 });
+
+    // Without cache, a tessellation neither reads from the cache nor adds to it
+    await box.TessellateParallel_async(stepData, note, true);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 0, misses: 6, entries: 6 });
+
+    const second = await copy.TessellateParallel_async(stepData, note, true, true);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 6, misses: 6, entries: 6 });
+    for (const [i, face] of second.faces.entries()) {
+        expect(face.position).toEqual(first.faces[i].position);
+        expect(face.simpleName).toBe(first.faces[i].simpleName);
+    }
+
+    await box.TessellateParallel_async(new c3d.StepData(c3d.StepType.SpaceStep, 0.01), note, true, true);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 6, misses: 12, entries: 12 });
+
+    expect(() => c3d.TessellationCache.SetBudget(-1)).toThrow();
+    c3d.TessellationCache.SetBudget(0);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ entries: 0, bytes: 0, evictions: 12 });
+    c3d.TessellationCache.SetBudget(256 * 1024 * 1024);
+    c3d.TessellationCache.Clear();
+});
+
+test("saving and loading the tessellation cache", async () => {
+    const coarse = new c3d.StepData(c3d.StepType.SpaceStep, 0.05);
+    const fine = new c3d.StepData(c3d.StepType.SpaceStep, 0.0009);
+    c3d.TessellationCache.Clear();
+    // Faces that aren't cached are meshed for saving, but not cached
+    const data = await c3d.TessellationCache.Save_async([box], [coarse, fine], note);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 0, misses: 0, entries: 0 });
+    const before = await box.TessellateLevels_async([coarse, fine], note, true, true);
+    expect(await c3d.TessellationCache.Save_async([box], [coarse, fine], note)).toEqual(data);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 0, misses: 12 });
+
+    // The grids are only used for a solid whose content is exactly what was saved, as when the file is reopened
+    c3d.TessellationCache.Clear();
+    expect(await c3d.TessellationCache.Load_async(data)).toBe(12);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ entries: 0 });
+    const points = [
+        new c3d.CartPoint3D(0, 0, 0),
+        new c3d.CartPoint3D(2, 0, 0),
+        new c3d.CartPoint3D(2, 2, 0),
+        new c3d.CartPoint3D(2, 2, 2),
+    ];
+    const other = c3d.ActionSolid.ElementarySolid(points, c3d.ElementaryShellType.Block, names);
+    await other.TessellateLevels_async([coarse, fine], note, true, true);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 0, misses: 12, entries: 12 });
+    const after = await makeBox().TessellateLevels_async([coarse, fine], note, true, true);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ hits: 12, misses: 12 });
+    for (const [l, { faces }] of after.entries()) {
+        for (const [i, face] of faces.entries()) {
+            expect(face.position).toEqual(before[l].faces[i].position);
+            expect(face.index).toEqual(before[l].faces[i].index);
+        }
+    }
+
+    expect(() => c3d.TessellationCache.Load(data.slice(0, data.length - 1))).toThrow();
+
+    // Loading never raises the budget; it stops at it instead
+    c3d.TessellationCache.Clear();
+    c3d.TessellationCache.SetBudget(1024);
+    expect(c3d.TessellationCache.Load(data)).toBeLessThan(12);
+    expect(c3d.TessellationCache.GetStats()).toMatchObject({ budget: 1024, evictions: 0 });
+    c3d.TessellationCache.SetBudget(256 * 1024 * 1024);
+    c3d.TessellationCache.Clear();
+});
+
+test("tessellation of several levels of detail at once", async () => {
+    const coarse = new c3d.StepData(c3d.StepType.SpaceStep, 0.05);
+    const fine = new c3d.StepData(c3d.StepType.SpaceStep, 0.0009);
+    const levels = await box.TessellateLevels_async([coarse, fine], note, true);
+    expect(levels.length).toBe(2);
+    const single = await box.TessellateParallel_async(fine, note, true);
+    for (const { faces, edges } of levels) {
+        expect(faces.length).toBe(6);
+        expect(edges.length).toBe(12);
+    }
+    for (const [i, face] of levels[1].faces.entries()) {
+        expect(face.position).toEqual(single.faces[i].position);
+    }
+});
+
+test("view dependent tessellation", async () => {
+    const camera = { eye: [0, -5, 0], direction: [0, 1, 0], fov: Math.PI / 4, height: 0, viewportHeight: 1000, pixelError: 1, minSag: 0.0001, maxSag: 0.1 };
+    const far = { ...camera, eye: [0, -500, 0] };
+    const [near_, far_] = await Promise.all([
+        c3d.ViewTessellation.Tessellate_async([sphere], camera, note, false),
+        c3d.ViewTessellation.Tessellate_async([sphere], far, note, false),
+    ]);
+    expect(near_.length).toBe(1);
+    expect(near_[0].faces.length).toBe(1);
+    expect(near_[0].faces[0].index.length).toBeGreaterThan(far_[0].faces[0].index.length);
+
+    const behind = { ...camera, direction: [0, -1, 0] };
+    const coarsest = c3d.ViewTessellation.Tessellate([sphere], behind, note, false);
+    const maxSag = await sphere.TessellateParallel_async(new c3d.StepData(c3d.StepType.SpaceStep, camera.maxSag), note, false);
+    expect(coarsest[0].faces[0].position).toEqual(maxSag.faces[0].position);
+});
+
+test("progressive tessellation", async () => {
+    const coarse = new c3d.StepData(c3d.StepType.SpaceStep, 0.05);
+    const fine = new c3d.StepData(c3d.StepType.SpaceStep, 0.0009);
+    const faces: c3d.MeshBuffer[] = [], edges: c3d.EdgeBuffer[] = [];
+    let done!: (success: boolean) => void;
+    const finished = new Promise<boolean>(resolve => done = resolve);
+    const first = await box.TessellateProgressive_async(coarse, fine, note, true, {
+        batch: (f, e) => { faces.push(...f); edges.push(...e) },
+        done,
+    });
+    expect(first.faces.length).toBe(6);
+    expect(first.edges.length).toBe(12);
+
+    expect(await finished).toBe(true);
+    expect(faces.length).toBe(6);
+    expect(edges.length).toBe(12);
+    const single = await box.TessellateParallel_async(fine, note, true);
+    for (const face of faces) {
+        expect(face.position).toEqual(single.faces[face.i].position);
+    }
+});
+
+test("streaming tessellation", async () => {
+    const faces: c3d.MeshBuffer[] = [], edges: c3d.EdgeBuffer[] = [];
+    let batches = 0, success: boolean | undefined = undefined;
+    await box.TessellateStreaming_async(stepData, note, true, {
+        batch: (f, e) => { batches++; faces.push(...f); edges.push(...e) },
+        done: s => success = s,
+    });
+    expect(success).toBe(true);
+    expect(batches).toBeGreaterThan(0);
+    expect(faces.map(f => f.i).sort()).toEqual([0, 1, 2, 3, 4, 5]);
+    expect(edges.length).toBe(12);
+});
+
+test("grid buffers outlive the mesh", async () => {
+    const buffers = () => {
+        const mesh = sphere.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+        const { index, position, normal } = mesh.GetBuffers()[0];
+        return { index, position, normal };
+    }
+    const { position } = buffers();
+    const copy = new Float32Array(position);
+    // Collect the mesh the buffers came from, then allocate over whatever it freed
+    global.gc!();
+    await new Promise(resolve => setImmediate(resolve));
+    buffers();
+    expect(position).toEqual(copy);
+});
+
+test("recycling mesh buffers", async () => {
+    c3d.TessellationCache.SetBudget(0);
+    c3d.MeshBufferPool.Clear();
+    let first: c3d.SolidTessellation | undefined = await box.TessellateParallel_async(stepData, note, true);
+    c3d.MeshBufferPool.Recycle(first.faces);
+    c3d.MeshBufferPool.Recycle(first.faces);
+    expect(c3d.MeshBufferPool.Count()).toBe(6);
+
+    // The grids are still referred to by first, so they can't be reused yet
+    const second = await box.TessellateParallel_async(stepData, note, true);
+    expect(c3d.MeshBufferPool.Count()).toBe(6);
+    for (const [i, face] of second.faces.entries()) {
+        expect(face.position).toEqual(first.faces[i].position);
+    }
+
+    // Once nothing refers to them, the next tessellation takes them from the pool
+    first = undefined;
+    global.gc!();
+    await new Promise(resolve => setImmediate(resolve));
+    const third = await box.TessellateParallel_async(stepData, note, true);
+    expect(c3d.MeshBufferPool.Count()).toBeLessThan(6);
+    for (const [i, face] of third.faces.entries()) {
+        expect(face.position).toEqual(second.faces[i].position);
+    }
+
+    c3d.MeshBufferPool.Clear();
+    c3d.TessellationCache.SetBudget(256 * 1024 * 1024);
+});
+
+test("face bounds and normal cones", async () => {
+    const { faces, bounds } = await box.TessellateParallel_async(stepData, note, true);
+    expect(bounds.length).toBe(10 * faces.length);
+    for (const [g, face] of faces.entries()) {
+        expect(face.bounds).toEqual(bounds.subarray(10 * g, 10 * g + 10));
+        const cube = face.grid.GetCube();
+        expect(face.bounds![0]).toBeCloseTo(cube.pmin.x);
+        expect(face.bounds![4]).toBeCloseTo(cube.pmax.y);
+        // Planar faces have a degenerate cone along their normal
+        const [x, y, z] = face.bounds!.subarray(6, 9);
+        expect(Math.abs(x) + Math.abs(y) + Math.abs(z)).toBeCloseTo(1);
+        expect(face.bounds![9]).toBeCloseTo(0);
+    }
+});
+
+test("welded buffers", () => {
+    const mesh = box.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+    const packed = mesh.GetPackedBuffers();
+
+    // The faces of a box meet at right angles, so nothing welds unless the angle allows it
+    const sharp = mesh.GetWeldedBuffers(1e-6, Math.PI / 4);
+    expect(sharp.position.length).toBe(packed.position.length);
+    expect(sharp.index).toEqual(packed.index);
+
+    const welded = mesh.GetWeldedBuffers(1e-6, Math.PI);
+    expect(welded.position.length).toBe(3 * 8);
+    expect(welded.index.length).toBe(packed.index.length);
+    expect(welded.faceIndex.length).toBe(welded.index.length / 3);
+    expect(welded.groups.length).toBe(packed.groups.length);
+});
+
+test("feature and silhouette edges", () => {
+    // Every corner of a box joins 3 creases, so each of its 12 edges is a polyline of its own
+    const boxMesh = box.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+    const creases = boxMesh.GetFeatureEdges(1e-6, Math.PI / 4);
+    expect(creases.offsets.length).toBe(12 + 1);
+    expect(creases.position.length).toBe(3 * 2 * 12);
+
+    // A smooth sphere has no creases, but its outline seen from above is a closed loop
+    const sphereMesh = sphere.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh);
+    expect(sphereMesh.GetFeatureEdges(1e-6, Math.PI / 4).offsets.length).toBe(1);
+    const silhouettes = new c3d.SilhouetteEdges(sphereMesh, 1e-6);
+    const camera = { eye: [0, 0, 10], direction: [0, 0, -1], fov: 0, height: 0, viewportHeight: 0, pixelError: 0, minSag: 0, maxSag: 0 };
+    const silhouette = silhouettes.Get(camera);
+    expect(silhouette.offsets.length).toBeGreaterThan(1);
+    const { position, offsets } = silhouette;
+    for (let j = 0; j < offsets[offsets.length - 1]; j++) {
+        expect(position[3 * j + 2]).toBeCloseTo(0, 1);
+    }
+
+    // Seen from the side, the same welded mesh gives the outline in the other plane
+    const side = silhouettes.Get({ ...camera, eye: [10, 0, 0], direction: [-1, 0, 0] });
+    expect(side.offsets.length).toBeGreaterThan(1);
+    for (let j = 0; j < side.offsets[side.offsets.length - 1]; j++) {
+        expect(side.position[3 * j]).toBeCloseTo(0, 1);
+    }
+});
+
+test("instanced tessellation", async () => {
+    const params = new c3d.DuplicationMeshValues(false, new c3d.Vector3D(1, 0, 0), 2, 3, new c3d.Vector3D(0, 1, 0), 2, 2, new c3d.CartPoint3D(0, 0, 0), false);
+    const expected = params.GenerateTransformMatrices();
+
+    const { faces, matrices } = await box.TessellateInstanced_async(params, stepData, note, true);
+    expect(faces.length).toBe(6);
+    expect(matrices.length).toBe(16 * expected.length);
+    for (const [k, matrix] of expected.entries()) {
+        const translation = matrix.GetRow(3);
+        expect(matrices[16 * k + 12]).toBeCloseTo(translation.x);
+        expect(matrices[16 * k + 13]).toBeCloseTo(translation.y);
+        expect(matrices[16 * k + 14]).toBeCloseTo(translation.z);
+    }
+});
+
+test("batched region tessellation", async () => {
+    const placement = new c3d.Placement3D();
+    const regions = [1, 2, 3].map(radius => {
+        const contour = new c3d.Contour([new c3d.Arc(radius)], false);
+        return c3d.ActionRegion.GetCorrectRegions([contour], false)[0];
+    });
+
+    const note = new c3d.FormNote(true, true, false, false, false);
+    const { index, position, normal, groups } = await c3d.RegionTessellation.Tessellate_async(regions, placement, stepData, note);
+    expect(groups.length).toBe(4 * regions.length);
+    expect(normal.length).toBe(position.length);
+
+    for (const [k, region] of regions.entries()) {
+        const [indexStart, indexCount, pointStart, pointCount] = groups.subarray(4 * k, 4 * k + 4);
+        const expected = new c3d.PlaneInstance(region, placement).CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh).GetBuffers()[0];
+        expect(indexCount).toBe(expected.index.length);
+        expect(pointCount).toBe(expected.position.length / 3);
+        expect(index.subarray(indexStart, indexStart + indexCount)).toEqual(expected.index);
+        expect(position.subarray(3 * pointStart, 3 * (pointStart + pointCount))).toEqual(expected.position);
+    }
+});
+
+test("batched curve tessellation", async () => {
+    const instances = [1, 2, 3].map(radius => {
+        const arc = new c3d.Arc3D(new c3d.Placement3D(), radius, radius, 2 * Math.PI);
+        return new c3d.SpaceInstance(arc);
+    });
+
+    const note = new c3d.FormNote(true, true, false, false, false);
+    const { position, offsets, items } = await c3d.CurveTessellation.Tessellate_async(instances, stepData, note);
+    expect(items.length).toBe(instances.length + 1);
+    expect(offsets.length).toBe(items[instances.length] + 1);
+
+    for (const [k, instance] of instances.entries()) {
+        const expected = instance.CreateMesh(stepData, note).Cast<c3d.Mesh>(c3d.SpaceType.Mesh).GetEdges();
+        expect(items[k + 1] - items[k]).toBe(expected.length);
+        for (const [j, edge] of expected.entries()) {
+            const p = items[k] + j;
+            expect(position.subarray(3 * offsets[p], 3 * offsets[p + 1])).toEqual(edge.position);
+        }
+    }
+});
+
+
+test("batched raycasting against a triangle bvh", async () => {
+    const { faces } = await box.TessellateParallel_async(stepData, note, true);
+    const bvh = new c3d.MeshBVH(faces.map(face => face.grid));
+    expect(bvh.triangleCount).toBe(faces.reduce((sum, face) => sum + face.index.length / 3, 0));
+
+    const rays = new Float32Array([
+        0.5, 0.5, 5, 0, 0, -1,
+        0.5, 0.5, -5, 0, 0, 1,
+        5, 5, 5, 0, 0, -1,
+    ]);
+    const { faces: hits, t, point } = bvh.Raycast(rays);
+    expect(hits[0]).toBeGreaterThanOrEqual(0);
+    expect(t[0]).toBeCloseTo(4);
+    expect([...point.subarray(0, 3)]).toEqual([0.5, 0.5, 1]);
+    expect(faces[hits[0]].position.filter((_, i) => i % 3 == 2).every(z => z == 1)).toBe(true);
+
+    expect(hits[1]).not.toBe(hits[0]);
+    expect(t[1]).toBeCloseTo(5);
+    expect(hits[2]).toBe(-1);
+
+    // Past near, the first ray goes on to the bottom face; short of far, it misses altogether
+    const beyond = bvh.Raycast(rays.subarray(0, 6), 4.5);
+    expect(beyond.faces[0]).toBe(hits[1]);
+    expect(beyond.t[0]).toBeCloseTo(5);
+    expect(bvh.Raycast(rays.subarray(0, 6), 0, 3).faces[0]).toBe(-1);
+});
+
+test('boxcasting against a triangle bvh', async () => {
+    const { faces } = await box.TessellateParallel_async(stepData, note, true);
+    const edges = [
+        new Float32Array([0, 0, 0, 0.5, 0, 0, 0.5, 0, 0, 1, 0, 0]),
+        new Float32Array([0, 0, 0, 0, 0, 1]),
+    ];
+    const bvh = new c3d.MeshBVH(faces.map(face => face.grid), edges);
+
+    // -1 <= y, z <= 2 and -1 <= x <= xmax
+    const planes = (xmax: number) => new Float32Array([
+        1, 0, 0, 1, -1, 0, 0, xmax,
+        0, 1, 0, 1, 0, -1, 0, 2,
+        0, 0, 1, 1, 0, 0, -1, 2,
+    ]);
+
+    const all = bvh.Boxcast(planes(2), true);
+    expect(all.faces.length).toBe(faces.length);
+    expect([...all.edges]).toEqual([0, 1]);
+
+    const contained = bvh.Boxcast(planes(0.5), true);
+    expect(contained.faces.length).toBe(1);
+    expect(faces[contained.faces[0]].position.filter((_, i) => i % 3 == 0).every(x => x == 0)).toBe(true);
+    expect([...contained.edges]).toEqual([1]);
+
+    const intersected = bvh.Boxcast(planes(0.5), false);
+    expect(intersected.faces.length).toBe(faces.length - 1);
+    expect([...intersected.edges]).toEqual([0, 1]);
+
+    const none = bvh.Boxcast(planes(-0.5), false);
+    expect(none.faces.length).toBe(0);
+    expect(none.edges.length).toBe(0);
+});
@@ -6,7 +6,7 @@ import SphereFactory from "../src/commands/sphere/SphereFactory";
 import { EditorSignals } from "../src/editor/EditorSignals";
 import { GeometryDatabase } from "../src/editor/GeometryDatabase";
 import MaterialDatabase from '../src/editor/MaterialDatabase';
-import { BasicMeshCreator, DoCacheMeshCreator, FaceCacheMeshCreator, ObjectCacheMeshCreator, ParallelMeshCreator } from "../src/editor/MeshCreator";
+import { BasicMeshCreator, DoCacheMeshCreator, FaceCacheMeshCreator, MeshLike, ObjectCacheMeshCreator, ParallelMeshCreator } from "../src/editor/MeshCreator";
 import { SolidCopier } from "../src/editor/SolidCopier";
 import * as visual from '../src/visual_model/VisualModel';
 import { FakeMaterials } from "../__mocks__/FakeMaterials";
@@ -84,18 +84,14 @@ describe(ParallelMeshCreator, () => {
 });
 
 describe(ObjectCacheMeshCreator, () => {
-    let calculateGrid: jest.SpyInstance;
-
-    beforeEach(() => {
-        calculateGrid = jest.spyOn(c3d.TriFace, 'CalculateGrid_async');
-    })
-
     let cache: ObjectCacheMeshCreator;
     let underlying: ParallelMeshCreator;
+    let create: jest.SpyInstance;
 
     beforeEach(() => {
         underlying = new ParallelMeshCreator();
         cache = new ObjectCacheMeshCreator(underlying);
+        create = jest.spyOn(underlying, 'create');
     });
 
     beforeEach(() => {
@@ -112,11 +108,11 @@ describe(ObjectCacheMeshCreator, () => {
 
     test('with cache, object hit', async () => {
         const { edges: edges1, faces: faces1 } = await cache.create(item, stepData, formNote, true, true);
-        expect(calculateGrid).toBeCalledTimes(6);
-        calculateGrid.mockClear();
+        expect(create).toBeCalledTimes(1);
+        create.mockClear();
 
         const { edges: edges2, faces: faces2 } = await cache.create(item, stepData, formNote, true, true);
-        expect(calculateGrid).toBeCalledTimes(0);
+        expect(create).toBeCalledTimes(0);
 
         expect(faces1).toBe(faces2);
         expect(edges1).toBe(edges2);
@@ -124,25 +120,24 @@ describe(ObjectCacheMeshCreator, () => {
 
     test('with cache, object hit but different precisions', async () => {
         const { edges: edges1, faces: faces1 } = await cache.create(item, stepData, formNote, true, true);
-        expect(calculateGrid).toBeCalledTimes(6);
-        calculateGrid.mockClear();
+        expect(create).toBeCalledTimes(1);
+        create.mockClear();
 
         const stepData2 = new c3d.StepData(c3d.StepType.SpaceStep, 0.5);
         const { edges: edges2, faces: faces2 } = await cache.create(item, stepData2, formNote, true, true);
-        expect(calculateGrid).toBeCalledTimes(6);
+        expect(create).toBeCalledTimes(1);
 
         expect(faces1).not.toBe(faces2);
         expect(edges1).not.toBe(edges2);
     });
 });
 
-describe(FaceCacheMeshCreator, () => {
-    let calculateGrid: jest.SpyInstance;
-
-    beforeEach(() => {
-        calculateGrid = jest.spyOn(c3d.TriFace, 'CalculateGrid_async');
-    })
+function reused(before: MeshLike, after: MeshLike) {
+    const positions = new Set(before.faces.map(f => f.position));
+    return after.faces.filter(f => positions.has(f.position)).length;
+}
 
+describe(FaceCacheMeshCreator, () => {
     let cache: FaceCacheMeshCreator;
     beforeEach(() => {
         cache = new FaceCacheMeshCreator(new ParallelMeshCreator(), copier);
@@ -159,7 +154,6 @@ describe(FaceCacheMeshCreator, () => {
         makeBox.p3 = new THREE.Vector3(1, 1, 0);
         makeBox.p4 = new THREE.Vector3(1, 1, 1);
         box = await makeBox.commit() as visual.Solid;
-        calculateGrid.mockClear();
     })
 
     test('with cache face hit', async () => {
@@ -174,12 +168,20 @@ describe(FaceCacheMeshCreator, () => {
             makeFillet.distance = 0.15;
             item2 = await makeFillet.calculate();
 
-            await cache.create(item1, stepData, formNote, true, false);
-            expect(calculateGrid).toBeCalledTimes(7);
-            calculateGrid.mockClear();
+            const result1 = await cache.create(item1, stepData, formNote, true, false);
+            expect(result1.faces.length).toBe(7);
+
+            const result2 = await cache.create(item2, stepData, formNote, true, false);
+            expect(result2.faces.length).toBe(7);
+            expect(reused(result1, result2)).toBe(2);
+            const indices = result2.faces.map(f => f.i).sort();
+            expect(indices).toEqual([0, 1, 2, 3, 4, 5, 6]);
 
-            await cache.create(item2, stepData, formNote, true, false);
-            expect(calculateGrid).toBeCalledTimes(5);
+            // Reused faces are still held by the cache, so discarding result2 mustn't recycle them
+            const positions = new Set(result1.faces.map(f => f.position));
+            for (const face of result2.faces) {
+                if (positions.has(face.position)) expect(result2.shared!.has(face.grid)).toBe(true);
+            }
         });
     });
 
@@ -194,12 +196,12 @@ describe(FaceCacheMeshCreator, () => {
         makeFillet.distance = 0.15;
         item2 = await makeFillet.calculate();
 
-        await cache.create(item1, stepData, formNote, true, false);
-        expect(calculateGrid).toBeCalledTimes(7);
-        calculateGrid.mockClear();
+        const result1 = await cache.create(item1, stepData, formNote, true, false);
+        expect(result1.faces.length).toBe(7);
 
-        await cache.create(item2, stepData, formNote, true, false);
-        expect(calculateGrid).toBeCalledTimes(7);
+        const result2 = await cache.create(item2, stepData, formNote, true, false);
+        expect(result2.faces.length).toBe(7);
+        expect(reused(result1, result2)).toBe(0);
     });
 
     test('when includemetdata=true, indices are correct', async () => {
@@ -230,10 +232,10 @@ describe(DoCacheMeshCreator, () => {
     })
 
     let cache: DoCacheMeshCreator;
-    let underlying: ParallelMeshCreator;
+    let fallback: ParallelMeshCreator;
     beforeEach(() => {
-        cache = new DoCacheMeshCreator(new ParallelMeshCreator(), copier);
-        underlying = new ParallelMeshCreator();
+        fallback = new ParallelMeshCreator();
+        cache = new DoCacheMeshCreator(fallback, copier);
         db = new GeometryDatabase(cache, copier, materials, signals);
         makeFillet = new FilletFactory(db, materials, signals);
     })
@@ -261,12 +263,15 @@ describe(DoCacheMeshCreator, () => {
         makeFillet.distance = 0.15;
         item2 = await makeFillet.calculate();
 
+        const create = jest.spyOn(fallback, 'create');
         await cache.create(item1, stepData, formNote, true, false);
-        expect(calculateGrid).toBeCalledTimes(7);
-        calculateGrid.mockClear();
+        expect(create).toBeCalledTimes(1);
+        expect(calculateGrid).toBeCalledTimes(0);
+        create.mockClear();
 
         await cache.create(item2, stepData, formNote, true, false);
-        expect(calculateGrid).toBeCalledTimes(7);
+        expect(create).toBeCalledTimes(1);
+        expect(calculateGrid).toBeCalledTimes(0);
     });
 
     test('with cache turned on', async () => {
@@ -282,12 +287,10 @@ describe(DoCacheMeshCreator, () => {
                 makeFillet.distance = 0.15;
                 item2 = await makeFillet.calculate();
 
-                await cache.create(item1, stepData, formNote, true, false);
-                expect(calculateGrid).toBeCalledTimes(7);
-                calculateGrid.mockClear();
-
-                await cache.create(item2, stepData, formNote, true, false);
-                expect(calculateGrid).toBeCalledTimes(5);
+                const result1 = await cache.create(item1, stepData, formNote, true, false);
+                const result2 = await cache.create(item2, stepData, formNote, true, false);
+                expect(reused(result1, result2)).toBe(2);
+                expect(calculateGrid).toBeCalledTimes(0);
             });
         })
     })
@@ -0,0 +1,49 @@
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import c3d from '../build/Release/c3d.node';
+import './matchers';
+
+test("writing meshes to files", async () => {
+    const points = [
+        new c3d.CartPoint3D(0, 0, 0),
+        new c3d.CartPoint3D(1, 0, 0),
+        new c3d.CartPoint3D(1, 1, 0),
+        new c3d.CartPoint3D(1, 1, 1),
+    ];
+    const names = new c3d.SNameMaker(c3d.CreatorType.ElementarySolid, c3d.ESides.SideNone, 0);
+    const box = c3d.ActionSolid.ElementarySolid(points, c3d.ElementaryShellType.Block, names);
+
+    const stepData = new c3d.StepData(c3d.StepType.SpaceStep, 0.003);
+    const note = new c3d.FormNote(false, true, false, false, true);
+    const mesh = await box.CalculateMesh_async(stepData, note);
+    const triangles = mesh.GetPackedBuffers().index.length / 3;
+    expect(c3d.MeshExport.CountTriangles([mesh])).toBe(triangles);
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'mesh-'));
+
+    const stl = path.join(dir, 'box.stl');
+    expect(await c3d.MeshExport.WriteStl_async([mesh], stl, 10)).toBe(triangles);
+    const buffer = fs.readFileSync(stl);
+    expect(buffer.length).toBe(84 + 50 * triangles);
+    expect(buffer.readUInt32LE(80)).toBe(triangles);
+    // The first corner of the first triangle, scaled
+    expect(Math.abs(buffer.readFloatLE(84 + 12))).toBeLessThanOrEqual(10);
+
+    const obj = path.join(dir, 'box.obj');
+    expect(c3d.MeshExport.WriteObj([mesh], obj, 1)).toBe(triangles);
+    const lines = fs.readFileSync(obj, 'utf8').split('\n');
+    expect(lines.filter(line => line.startsWith('f ')).length).toBe(triangles);
+
+    const glb = path.join(dir, 'box.glb');
+    const indicator = new c3d.ProgressIndicator();
+    indicator.progress = (n: number) => { };
+    expect(await c3d.MeshExport.WriteGlb_async([mesh], glb, 1, indicator)).toBe(triangles);
+    const binary = fs.readFileSync(glb);
+    expect(binary.readUInt32LE(0)).toBe(0x46546C67);
+    expect(binary.readUInt32LE(8)).toBe(binary.length);
+    const json = JSON.parse(binary.toString('utf8', 20, 20 + binary.readUInt32LE(12)));
+    expect(json.meshes.length).toBe(1);
+    expect(json.buffers[0].byteLength).toBe(binary.length - 28 - binary.readUInt32LE(12));
+
+    fs.rmSync(dir, { recursive: true });
+});
@@ -0,0 +1,19 @@
+import c3d from '../build/Release/c3d.node';
+import './matchers';
+
+test("intersecting solids whose bounding boxes overlap", async () => {
+    const names = new c3d.SNameMaker(c3d.CreatorType.ElementarySolid, c3d.ESides.SideNone, 0);
+    const block = (x: number) => c3d.ActionSolid.ElementarySolid([
+        new c3d.CartPoint3D(x, 0, 0),
+        new c3d.CartPoint3D(x + 1, 0, 0),
+        new c3d.CartPoint3D(x + 1, 1, 0),
+        new c3d.CartPoint3D(x + 1, 1, 1),
+    ], c3d.ElementaryShellType.Block, names);
+
+    const solid = block(0);
+    const candidates = [block(0.5), block(10), block(-20), block(-0.5)];
+    const intersecting = await c3d.SolidIntersection.Intersect_async([solid], candidates, names);
+    expect([...intersecting]).toEqual([1, 0, 0, 1]);
+
+    expect([...c3d.SolidIntersection.Intersect([], candidates, names)]).toEqual([0, 0, 0, 0]);
+});
@@ -152,4 +152,49 @@ test('three intersecting circles, added then deleted', async () => {
 
     crosses.remove(1);
     expect(crosses.crosses.size).toBe(0);
-});
\ No newline at end of file
+});
+test('three intersecting circles, added in one batch', async () => {
+    makeCircle1.center = new THREE.Vector3(0, -1.1, 0);
+    makeCircle1.radius = 1;
+    const circle1 = (await makeCircle1.calculate()).GetSpaceItem()!.Cast<c3d.Curve3D>(c3d.SpaceType.Curve3D);
+    makeCircle2.center = new THREE.Vector3(0, 0, 0);
+    makeCircle2.radius = 1;
+    const circle2 = (await makeCircle2.calculate()).GetSpaceItem()!.Cast<c3d.Curve3D>(c3d.SpaceType.Curve3D);
+    makeCircle3.center = new THREE.Vector3(0, 1.1, 0);
+    makeCircle3.radius = 1;
+    const circle3 = (await makeCircle3.calculate()).GetSpaceItem()!.Cast<c3d.Curve3D>(c3d.SpaceType.Curve3D);
+
+    crosses.add(0, circle1);
+    const batch = [crosses.addAsync(1, circle2), crosses.addAsync(2, circle3)];
+    expect(crosses.crosses.size).toBe(0);
+    await Promise.all(batch);
+    expect(crosses.crosses.size).toBe(4);
+
+    // A curve removed before its batch runs is dropped
+    crosses.remove(2);
+    const dropped = crosses.addAsync(2, circle3);
+    crosses.remove(2);
+    await dropped;
+    expect(crosses.crosses.size).toBe(2);
+
+    crosses.remove(1);
+    expect(crosses.crosses.size).toBe(0);
+});
+
+test('a batch whose intersection fails rejects, and the next batch still runs', async () => {
+    makeCircle1.center = new THREE.Vector3(0, -1.1, 0);
+    makeCircle1.radius = 1;
+    const circle1 = (await makeCircle1.calculate()).GetSpaceItem()!.Cast<c3d.Curve3D>(c3d.SpaceType.Curve3D);
+    makeCircle2.center = new THREE.Vector3(0, 0, 0);
+    makeCircle2.radius = 1;
+    const circle2 = (await makeCircle2.calculate()).GetSpaceItem()!.Cast<c3d.Curve3D>(c3d.SpaceType.Curve3D);
+
+    crosses.add(0, circle1);
+    const intersect = jest.spyOn(c3d.CurveIntersection, 'Intersect_async').mockRejectedValueOnce(new Error("intersection failed"));
+    await expect(crosses.addAsync(1, circle2)).rejects.toThrow("intersection failed");
+    expect(crosses.crosses.size).toBe(0);
+    intersect.mockRestore();
+
+    await crosses.addAsync(1, circle2);
+    expect(crosses.crosses.size).toBe(2);
+});
@@ -269,3 +269,16 @@ test("serialize & deserialize", async () => {
 
     expect(db.items[0].view.simpleName).toBe(1);
 })
+
+test("load keeps the order of the model's items", async () => {
+    const curve = new c3d.LineSegment3D(new c3d.CartPoint3D(0, 0, 0), new c3d.CartPoint3D(1, 0, 0));
+    const model = new c3d.Model();
+    model.AddItem(new c3d.SpaceInstance(curve));
+    model.AddItem(box);
+
+    const [first, second] = await db.load(model);
+    expect(first).toBeInstanceOf(visual.SpaceInstance);
+    expect(first.simpleName).toBe(1);
+    expect(second).toBeInstanceOf(visual.Solid);
+    expect(second.simpleName).toBe(2);
+})
@@ -12,7 +12,7 @@ import { Scene } from "../../src/editor/Scene";
 import { SolidCopier } from "../../src/editor/SolidCopier";
 import { SelectionDatabase } from "../../src/selection/SelectionDatabase";
 import { ControlPointGroup, Curve3D, CurveEdge, CurveGroup, GeometryGroupUtils, SpaceInstance } from '../../src/visual_model/VisualModel';
-import { CurveEdgeGroupBuilder, CurveSegmentGroupBuilder, mergeBufferAttributes, mergeBufferGeometries } from '../../src/visual_model/VisualModelBuilder';
+import { CurveBuilder, CurveEdgeGroupBuilder, CurveSegmentGroupBuilder, mergeBufferAttributes, mergeBufferGeometries, packedBufferGeometry } from '../../src/visual_model/VisualModelBuilder';
 import { BetterRaycastingPoints } from "../../src/visual_model/VisualModelRaycasting";
 import { FakeMaterials } from "../../__mocks__/FakeMaterials";
 
@@ -176,4 +176,33 @@ describe(mergeBufferGeometries, () => {
         expect(result.attributes.normal.array).toEqual(new Float32Array([10, 11, 12, 13, 14, 15]));
     })
 
-});
\ No newline at end of file
+});
+
+describe(packedBufferGeometry, () => {
+    test('it works', () => {
+        const packed: c3d.PackedMeshBuffer = {
+            index: new Uint32Array([0, 1, 0, 1, 2, 3]),
+            position: new Float32Array([1, 2, 3, 4, 5, 6]),
+            normal: new Float32Array([10, 11, 12, 13, 14, 15]),
+            groups: new Uint32Array([0, 2, 0, 0, 100, 2, 4, 1, 0, 101]),
+        }
+        const result = packedBufferGeometry(packed);
+        expect(result.index!.array).toBe(packed.index);
+        expect(result.attributes.position.array).toBe(packed.position);
+        expect(result.attributes.normal.array).toBe(packed.normal);
+        expect(result.groups).toEqual([{ start: 0, count: 2, materialIndex: 0 }, { start: 2, count: 4, materialIndex: 1 }]);
+    })
+});
+
+describe(CurveBuilder.mergePackedPositions, () => {
+    test('it matches mergePositions', () => {
+        const a = new Float32Array([0, 0, 0, 1, 0, 0, 1, 1, 0]);
+        const b = new Float32Array([2, 2, 2, 3, 3, 3]);
+        const position = new Float32Array([...a, ...b]);
+        const offsets = new Uint32Array([0, 3, 5]);
+        const expected = CurveBuilder.mergePositions([a, b]);
+        const result = CurveBuilder.mergePackedPositions(position, offsets);
+        expect(result.array).toEqual(expected.array);
+        expect(result.groups).toEqual(expected.groups);
+    })
+});
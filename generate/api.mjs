@@ -217,7 +217,7 @@ export default {
         Solid: {
             rawHeader: "solid.h",
             extends: "Item",
-            dependencies: ["StepData.h", "FormNote.h", "Item.h", "CurveEdge.h", "Face.h", "FaceShell.h", "Creator.h"],
+            dependencies: ["StepData.h", "FormNote.h", "Item.h", "CurveEdge.h", "Face.h", "FaceShell.h", "Creator.h", "_DuplicationValues.h"],
             initializers: [
                 "MbFaceShell * shell, MbCreator * creator",
                 "MbFaceShell & shell, const MbSolid & solid, MbCreator * creator = nullptr",
@@ -242,6 +242,12 @@ export default {
                 "void MakeRight()",
                 "bool IsRight()",
                 "MbeItemLocation SolidClassification(const MbSolid & solid, double epsilon = Math::metricRegion)",
+                { signature: "void TessellateParallel(const MbStepData & stepData, const MbFormNote & formNote, bool outlinesOnly, bool cache = false, SolidTessellation & result)", isManual, result: isReturn },
+                { signature: "void TessellateLevels(const RPArray<MbStepData> & stepDatas, const MbFormNote & formNote, bool outlinesOnly, bool cache = false, RPArray<SolidTessellation> & result)", isManual, result: isReturn },
+                { signature: "void TessellateProgressive(const MbStepData & coarse, const MbStepData & fine, const MbFormNote & formNote, bool outlinesOnly, const TessellationStream & stream, SolidTessellation & result)", isManual, result: isReturn },
+                { signature: "void TessellateStreaming(const MbStepData & stepData, const MbFormNote & formNote, bool outlinesOnly, const TessellationStream & stream)", isManual },
+                { signature: "void TessellateInstanced(const DuplicationValues & params, const MbStepData & stepData, const MbFormNote & formNote, bool outlinesOnly, InstancedTessellation & result)", isManual, result: isReturn },
+                { signature: "void TessellateIncremental(const RPArray<SolidDuplicate> & histories, const KnownTessellation & known, const MbStepData & stepData, const MbFormNote & formNote, bool outlinesOnly, IncrementalTessellation & result)", isManual, result: isReturn },
             ]
         },
         Assembly: {
@@ -785,8 +791,13 @@ export default {
             initializers: ["bool doExact"],
             functions: [
                 { signature: "void GetBuffers(RPArray<MeshBuffer> & result)", isManual, result: isReturn },
+                { signature: "void GetPackedBuffers(PackedMeshBuffer & result)", isManual, result: isReturn },
+                { signature: "void GetWeldedBuffers(double tolerance, double angle, WeldedMeshBuffer & result)", isManual, result: isReturn },
+                { signature: "void GetQuantizedBuffers(RPArray<QuantizedMeshBuffer> & result)", isManual, result: isReturn },
                 { signature: "Float32Array GetApexes()", isManual },
                 { signature: "void GetEdges(bool outlinesOnly = false, RPArray<EdgeBuffer> &result)", isManual, result: isReturn },
+                { signature: "void GetPackedEdges(bool outlinesOnly = false, PackedEdgeBuffer & result)", isManual, result: isReturn },
+                { signature: "void GetFeatureEdges(double tolerance, double angle, FeatureEdgeBuffer & result)", isManual, result: isReturn },
                 "MbeSpaceType GetMeshType()",
                 "void ConvertAllToTriangles()",
                 "bool IsClosed()",
@@ -1641,6 +1652,7 @@ export default {
                 "const void * CreateGridTopology(bool keepExisting)",
                 "bool IsGridTopologyReady()",
                 { signature: "void GetBuffers(MeshBuffer & result)", isManual, result: isReturn },
+                { signature: "void GetQuantizedBuffers(QuantizedGridBuffer & result)", isManual, result: isReturn },
             ]
         },
         Polygon3D: {
@@ -2072,6 +2084,72 @@ export default {
                 "void ExitParallelRegion()"
             ]
         },
+        TessellationCache: {
+            rawHeader: "mesh.h",
+            dependencies: ["TessellationAddon.h", "Solid.h", "StepData.h", "FormNote.h"],
+            functions: [
+                { signature: "void SetBudget(size_t bytes)", isManual },
+                { signature: "void Clear()", isManual },
+                { signature: "void GetStats(TessellationCacheStats & result)", isManual, result: isReturn },
+                { signature: "void Save(const RPArray<MbSolid> & solids, const RPArray<MbStepData> & stepDatas, const MbFormNote & formNote, const char *& result)", isManual, result: isReturn },
+                { signature: "size_t Load(const void * data)", isManual },
+            ]
+        },
+        MeshBufferPool: {
+            rawHeader: "mesh.h",
+            dependencies: ["TessellationAddon.h"],
+            functions: [
+                { signature: "void Recycle(const RPArray<MeshBuffer> & buffers)", isManual },
+                { signature: "void Pack(const RPArray<MeshBuffer> & buffers, PackedMeshBuffer & result)", isManual, result: isReturn },
+                { signature: "void Clear()", isManual },
+                { signature: "size_t Count()", isManual },
+            ]
+        },
+        ViewTessellation: {
+            rawHeader: "mesh.h",
+            dependencies: ["TessellationAddon.h", "Solid.h", "FormNote.h"],
+            functions: [
+                { signature: "void Tessellate(const RPArray<MbSolid> & solids, const ViewCamera & camera, const MbFormNote & formNote, bool outlinesOnly, RPArray<SolidTessellation> & result)", isManual, result: isReturn },
+            ]
+        },
+        RegionTessellation: {
+            rawHeader: "mesh.h",
+            dependencies: ["TessellationAddon.h", "Region.h", "Placement3D.h", "StepData.h", "FormNote.h"],
+            functions: [
+                { signature: "void Tessellate(const RPArray<MbRegion> & regions, const MbPlacement3D & placement, const MbStepData & stepData, const MbFormNote & formNote, PackedRegionBuffer & result)", isManual, result: isReturn },
+            ]
+        },
+        CurveTessellation: {
+            rawHeader: "mesh.h",
+            dependencies: ["TessellationAddon.h", "SpaceInstance.h", "StepData.h", "FormNote.h"],
+            functions: [
+                { signature: "void Tessellate(const RPArray<MbSpaceInstance> & instances, const MbStepData & stepData, const MbFormNote & formNote, PackedCurveBuffer & result)", isManual, result: isReturn },
+            ]
+        },
+        MeshExport: {
+            rawHeader: "mesh.h",
+            dependencies: ["MeshExportAddon.h", "Mesh.h", "ProgressIndicator.h"],
+            functions: [
+                { signature: "size_t WriteStl(const RPArray<MbMesh> & meshes, const c3d::path_string & fileName, double scale, ProgressIndicator * indicator = NULL)", isManual, indicator: isRaw },
+                { signature: "size_t WriteObj(const RPArray<MbMesh> & meshes, const c3d::path_string & fileName, double scale, ProgressIndicator * indicator = NULL)", isManual, indicator: isRaw },
+                { signature: "size_t WriteGlb(const RPArray<MbMesh> & meshes, const c3d::path_string & fileName, double scale, ProgressIndicator * indicator = NULL)", isManual, indicator: isRaw },
+                { signature: "size_t CountTriangles(const RPArray<MbMesh> & meshes)", isManual },
+            ]
+        },
+        CurveIntersection: {
+            rawHeader: "action_point.h",
+            dependencies: ["CurveIntersectionAddon.h", "Curve3D.h"],
+            functions: [
+                { signature: "void Intersect(const RPArray<MbCurve3D> & curves, const RPArray<MbCurve3D> & others, double mEps, PackedCrossPoints & result)", isManual, result: isReturn },
+            ]
+        },
+        SolidIntersection: {
+            rawHeader: "action.h",
+            dependencies: ["SolidIntersectionAddon.h", "Solid.h", "SNameMaker.h"],
+            functions: [
+                { signature: "void Intersect(const RPArray<MbSolid> & solids, const RPArray<MbSolid> & candidates, const MbSNameMaker & names, IntersectingCandidates & result)", isManual, result: isReturn },
+            ]
+        },
         ContourGraph: {
             rawHeader: "contour_graph.h",
             dependencies: ["Curve.h", "Contour.h", "ProgressIndicator.h", "Graph.h"],
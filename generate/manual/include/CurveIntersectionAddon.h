@@ -0,0 +1,37 @@
+#ifndef CURVEINTERSECTIONADDON_H
+#define CURVEINTERSECTIONADDON_H
+
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+
+#include <napi.h>
+
+#include <curve3d.h>
+
+// Intersects each of curves with every other of curves and with each of others, but only where their bounding
+// boxes (grown by mEps) overlap: the boxes are swept along x to find the candidate pairs, which are then intersected
+// exactly in parallel. Curve i is curves[i] for i < curves.size() and others[i - curves.size()] after that.
+// The result packs one cross point per row: pairs[2k] (a curve) and pairs[2k+1] (any curve) are the two curves,
+// always with pairs[2k] < pairs[2k+1], and params[2k], params[2k+1] the parameters on each.
+class CurveIntersector
+{
+public:
+    CurveIntersector(const std::vector<const MbCurve3D *> &curves, const std::vector<const MbCurve3D *> &others, double mEps);
+    ~CurveIntersector();
+
+    bool Calculate();
+    Napi::Object ToJs(const Napi::Env env);
+
+private:
+    void Candidates();
+
+    const size_t count;
+    std::vector<const MbCurve3D *> curves;
+    const double mEps;
+    // The pairs of curves whose boxes overlap, then each pair's parameters
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+    std::vector<std::vector<double>> params1, params2;
+};
+
+#endif
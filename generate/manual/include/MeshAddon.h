@@ -3,10 +3,82 @@
 
 #include <sstream>
 #include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <unordered_map>
+#include <vector>
 #include <napi.h>
 
 #include <item_registrator.h>
+#include <mesh.h>
 
 void AutoReg(MbAutoRegDuplicate *&autoReg, MbRegDuplicate *&iReg);
 
+// Read object[key] as a number or an array of 3 numbers; otherwise throw (naming it <name>.<key>) and return false.
+bool getNumber(const Napi::Env env, const Napi::Object object, const char *name, const char *key, double &result);
+bool getTriple(const Napi::Env env, const Napi::Object object, const char *name, const char *key, double &x, double &y, double &z);
+
+// Grids with at most this many points get Uint16 indices; larger ones fall back to Uint32.
+#define SHORT_INDEX_LIMIT 65536
+
+template <typename Index>
+inline void copyIndex(Index *dst, const uint32_t *triangles, const size_t count, const size_t base)
+{
+    for (size_t j = 0; j < count; j++)
+        dst[j] = (Index)(triangles[j] + base);
+}
+
+// An ArrayBuffer over memory of the grid, holding a reference on the grid (and the mesh that owns it, if any)
+// until the last view of it is collected.
+Napi::ArrayBuffer getPinnedBuffer(const Napi::Env env, const void *data, size_t bytes, const MbGrid *grid, const MbMesh *mesh);
+// A Uint16Array copy of the grid's triangles when they fit, otherwise a Uint32Array view over them.
+Napi::TypedArray getIndex(const Napi::Env env, const MbGrid *grid, const MbMesh *mesh = NULL);
+// The views over the grid's memory keep it alive on their own; JS needn't hold on to the Grid or Mesh.
+Napi::Object getBuffer(const Napi::Env env, const size_t i, MbGrid *grid, const MbMesh *mesh = NULL);
+// Per grid: the bounding box (min xyz, max xyz) and a cone containing all its normals (axis xyz, half-angle in
+// radians). A grid without usable normals gets a zero axis and a half-angle of pi.
+#define GRID_BOUNDS_STRIDE 10
+void getGridBounds(const MbGrid &grid, float *result);
+// 16-bit positions relative to the grid's bounding cube (position = offset + scale * q / 65535)
+// and octahedral snorm16 normals.
+void getQuantizedBuffer(const Napi::Env env, const MbGrid *grid, Napi::Object &result);
+// Packs grids (with their index in the mesh) into one index/position/normal buffer, indices already rebased.
+// Each grid gets a row of PACKED_GROUP_STRIDE entries in `groups`: start, count, i, style, simpleName.
+#define PACKED_GROUP_STRIDE 5
+Napi::Object getPackedBuffers(const Napi::Env env, const std::vector<std::pair<size_t, const MbGrid *>> &grids);
+// Like getPackedBuffers, but vertices of any grids that lie within tolerance of each other and whose normals
+// are less than angle (radians) apart become one. faceIndex has the grid's index in the mesh for each triangle.
+Napi::Object getWeldedBuffers(const Napi::Env env, const std::vector<std::pair<size_t, const MbGrid *>> &grids, double tolerance, double angle);
+// The edges of the grids' triangles (welded within tolerance) chained into polylines, packed like getPackedEdges
+// but without simpleNames. Feature edges are boundary edges and those whose triangles' normals are more than
+// angle (radians) apart.
+Napi::Object getFeatureEdges(const Napi::Env env, const std::vector<std::pair<size_t, const MbGrid *>> &grids, double tolerance, double angle);
+
+// The welded triangles of a mesh's visible grids and the edges between them, built once so that each view only has
+// to decide which triangles face the eye. Get(camera) chains the edges between a triangle facing the eye and one
+// facing away as getFeatureEdges does; with fov 0 the camera is orthographic and only its direction matters.
+class SilhouetteEdges : public Napi::ObjectWrap<SilhouetteEdges>
+{
+public:
+    static Napi::Object Init(const Napi::Env env, Napi::Object exports);
+    SilhouetteEdges(const Napi::CallbackInfo &info);
+
+private:
+    Napi::Value Get(const Napi::CallbackInfo &info);
+
+    // The welded vertices, then a unit normal and centroid per triangle
+    std::vector<float> position, normal, centroid;
+    // The manifold edges (pairs of welded vertices, as getChainedEdges takes them) and the two triangles on each
+    std::vector<uint64_t> edges;
+    std::vector<uint32_t> edgeTriangles;
+};
+
+// Whether Mesh::GetEdges would export the polygon. With outlinesOnly, only curve edges that are neither poles nor seams.
+bool isDisplayedPolygon(const MbPolygon3D *polygon, bool outlinesOnly);
+bool getEdgeBuffer(const Napi::Env env, const MbPolygon3D *polygon, bool outlinesOnly, Napi::Object &result);
+// Packs polylines into one position buffer; offsets (in points) has one more entry than there are polylines.
+Napi::Object getPackedEdges(const Napi::Env env, const std::vector<const MbPolygon3D *> &polygons, const std::vector<SimpleName> &names);
+
 #endif
@@ -0,0 +1,66 @@
+#ifndef MESHBVH_H
+#define MESHBVH_H
+
+#include <cmath>
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+
+#include <napi.h>
+
+#include <mesh.h>
+
+// A bounding volume hierarchy over the triangles of several grids (say, the faces of a solid), built once in the
+// constructor from copies of the triangles. Raycast takes any number of rays packed in one Float32Array, 6 floats
+// (origin xyz, direction xyz) per ray, and finds the nearest hit of each with near <= t < far (0 and infinity by
+// default): { faces, t, point }, with faces[k] the index of the grid hit by ray k (or -1), t[k] the distance along
+// the ray in units of its direction, and point 3 floats per ray.
+//
+// It can also hold edges, given as polylines of segments (6 floats each, as in the instanceStart/instanceEnd of a
+// LineSegments2), each with its own bounding box. Boxcast takes the 6 planes of a selection frustum (nx, ny, nz,
+// constant each, inside where positive, as in THREE.Plane) and finds { faces, edges }, the indices of the grids and
+// edges entirely inside it or, unless contained, merely intersecting it.
+class MeshBVH : public Napi::ObjectWrap<MeshBVH>
+{
+public:
+    static Napi::Object Init(const Napi::Env env, Napi::Object exports);
+    static Napi::Function GetConstructor(Napi::Env env);
+    MeshBVH(const Napi::CallbackInfo &info);
+
+    // The index of the grid hit nearest, between near and far, or -1; t is only updated on a hit
+    int Intersect(const float origin[3], const float direction[3], float &t, float near = 0, float far = HUGE_VALF) const;
+
+private:
+    struct Node
+    {
+        float min[3], max[3];
+        // The left child is the next node and right is the right child, or 0 for leaves; either way the triangles
+        // of the subtree are first..first+count
+        uint32_t right, first, count;
+    };
+
+    void Build(const std::vector<const MbGrid *> &grids);
+    uint32_t Split(uint32_t first, uint32_t count);
+    void Bound(Node &node) const;
+    void SelectFaces(const float *planes, bool contained, std::vector<int32_t> &result) const;
+    void SelectEdges(const float *planes, bool contained, std::vector<int32_t> &result) const;
+
+    Napi::Value Raycast(const Napi::CallbackInfo &info);
+    Napi::Value Boxcast(const Napi::CallbackInfo &info);
+    Napi::Value GetValue_triangleCount(const Napi::CallbackInfo &info);
+
+    std::vector<Node> nodes;
+    // 9 floats per triangle, in the order of the leaves
+    std::vector<float> triangles;
+    std::vector<int32_t> triangleFaces;
+    size_t faceCount;
+    // 6 floats per segment; the segments of edge e are edgeFirst[e]..edgeFirst[e+1], bounded by edgeBounds[6*e..]
+    std::vector<float> segments;
+    std::vector<uint32_t> edgeFirst;
+    std::vector<float> edgeBounds;
+    // Centroids while building
+    std::vector<float> centroids;
+    std::vector<uint32_t> order;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef MESHEXPORTADDON_H
+#define MESHEXPORTADDON_H
+
+#include <sstream>
+#include <fstream>
+#include <stdio.h>
+#include <vector>
+
+#include <napi.h>
+
+#include <mesh.h>
+#include <tool_cstring.h>
+
+#include "ProgressIndicator.h"
+
+// Writes the triangles of meshes straight from their grids to a file, one grid at a time, without handing any
+// buffers to JS. Positions are multiplied by scale. The indicator, if any, gets Progress(n) after every few
+// thousand triangles (n being the triangles written since the last call) and can cancel the export.
+class MeshFileWriter
+{
+public:
+    enum Format
+    {
+        STL,
+        OBJ,
+        GLB
+    };
+
+    MeshFileWriter(Format format, const std::vector<const MbMesh *> &meshes, const c3d::path_string &fileName, double scale, const Napi::Value indicator);
+    ~MeshFileWriter();
+
+    // Writes the whole file; false if it couldn't be written or the export was cancelled
+    bool Calculate();
+    // The number of triangles written
+    Napi::Value ToJs(const Napi::Env env);
+
+private:
+    bool WriteStl(std::ofstream &out);
+    bool WriteObj(std::ofstream &out);
+    bool WriteGlb(std::ofstream &out);
+    bool Progress(size_t triangles);
+
+    const Format format;
+    std::vector<const MbMesh *> meshes;
+    const c3d::path_string fileName;
+    const float scale;
+    // Kept alive (and used from the worker thread) until the file is written
+    Napi::ObjectReference indicatorObject;
+    ProgressIndicator *indicator;
+    size_t written, reported;
+};
+
+#endif
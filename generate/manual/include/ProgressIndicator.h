@@ -22,6 +22,7 @@ class ProgressIndicator : public Napi::ObjectWrap<ProgressIndicator>, public IPr
 
 public:
     static Napi::Object Init(const Napi::Env env, Napi::Object exports);
+    static Napi::Function GetConstructor(Napi::Env env);
     ProgressIndicator(const Napi::CallbackInfo &info);
     virtual ~ProgressIndicator();
 
@@ -34,6 +35,10 @@ public:
     virtual void Stop();                                                // Команда пора остановиться
     virtual const TCHAR *Msg(IStrData &msg) const;                      // Получить строку
 
+    // Lets go of the progress callback (and so of this object), once whatever uses the indicator is done with it.
+    // Safe to call from any thread; Progress does nothing afterwards.
+    void ReleaseProgress();
+
 private:
     bool cancel;
     SUCCESS onSuccess;
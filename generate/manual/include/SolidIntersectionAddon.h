@@ -0,0 +1,31 @@
+#ifndef SOLIDINTERSECTIONADDON_H
+#define SOLIDINTERSECTIONADDON_H
+
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+
+#include <napi.h>
+
+#include <solid.h>
+#include <name_item.h>
+
+// Which of candidates intersect any of solids. Only pairs whose bounding boxes overlap are checked exactly
+// (IsSolidsIntersection), one candidate per native thread, stopping at the first solid it intersects.
+// The result has one byte per candidate, 1 if it intersects and 0 otherwise.
+class SolidIntersector
+{
+public:
+    SolidIntersector(const std::vector<const MbSolid *> &solids, const std::vector<const MbSolid *> &candidates, const MbSNameMaker &names);
+    ~SolidIntersector();
+
+    bool Calculate();
+    Napi::Value ToJs(const Napi::Env env);
+
+private:
+    std::vector<const MbSolid *> solids, candidates;
+    const MbSNameMaker names;
+    std::vector<uint8_t> intersecting;
+};
+
+#endif
@@ -2,6 +2,8 @@
 
 #include <sstream>
 #include <stdio.h>
+#include <mutex>
+#include <unordered_map>
 
 #include <napi.h>
 
@@ -19,7 +21,7 @@ public:
         original.GetFaces(originalFaces);
         copy.GetFaces(copyFaces);
 
-        const size_t faceCount = originalFaces.Count();
+        faceCount = originalFaces.Count();
         originalFaceIds = new uint64_t[faceCount];
         copyFaceIds = new uint64_t[faceCount];
 
@@ -37,7 +39,7 @@ public:
         original.GetEdges(originalEdges);
         copy.GetEdges(copyEdges);
 
-        const size_t edgeCount = originalEdges.Count();
+        edgeCount = originalEdges.Count();
         originalEdgeIds = new uint64_t[edgeCount];
         copyEdgeIds = new uint64_t[edgeCount];
 
@@ -54,10 +56,10 @@ public:
     ~SolidDuplicate()
     {
         copy.Release();
-        delete originalFaceIds;
-        delete copyFaceIds;
-        delete originalEdgeIds;
-        delete copyEdgeIds;
+        delete[] originalFaceIds;
+        delete[] copyFaceIds;
+        delete[] originalEdgeIds;
+        delete[] copyEdgeIds;
     }
 
     MbSolid *GetCopy()
@@ -65,12 +67,47 @@ public:
         return &copy;
     }
 
+    // The id of the original face/edge a face/edge of the copy was made from, or 0 if it wasn't.
+    uint64_t GetOriginalId(const MbFace *copyFace) const
+    {
+        std::call_once(historyBuilt, [this]()
+                       { BuildHistory(); });
+        std::unordered_map<uint64_t, uint64_t>::const_iterator found = faceHistory.find((uint64_t)copyFace);
+        return found == faceHistory.end() ? 0 : found->second;
+    }
+
+    uint64_t GetOriginalId(const MbEdge *copyEdge) const
+    {
+        std::call_once(historyBuilt, [this]()
+                       { BuildHistory(); });
+        std::unordered_map<uint64_t, uint64_t>::const_iterator found = edgeHistory.find((uint64_t)copyEdge);
+        return found == edgeHistory.end() ? 0 : found->second;
+    }
+
     uint64_t *originalFaceIds;
     uint64_t *copyFaceIds;
     uint64_t *originalEdgeIds;
     uint64_t *copyEdgeIds;
 
 private:
+    // Most duplicates are never asked, so the lookups from copy to original are only indexed on the first ask
+    void BuildHistory() const
+    {
+        faceHistory.reserve(faceCount);
+        for (size_t i = 0; i < faceCount; i++)
+            faceHistory[copyFaceIds[i]] = originalFaceIds[i];
+        edgeHistory.reserve(edgeCount);
+        for (size_t i = 0; i < edgeCount; i++)
+            edgeHistory[copyEdgeIds[i]] = originalEdgeIds[i];
+    }
+
+    size_t faceCount;
+    size_t edgeCount;
+    // NOTE: the original solid may be long gone, so its faces and edges are only ever used as ids
+    mutable std::once_flag historyBuilt;
+    mutable std::unordered_map<uint64_t, uint64_t> faceHistory;
+    mutable std::unordered_map<uint64_t, uint64_t> edgeHistory;
+
     MbSolid &copy;
 };
 
@@ -0,0 +1,412 @@
+#ifndef TESSELLATIONADDON_H
+#define TESSELLATIONADDON_H
+
+#include <sstream>
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <napi.h>
+
+#include <solid.h>
+#include <mesh.h>
+#include <mb_data.h>
+#include <mesh_primitive.h>
+#include <op_duplication_parameter.h>
+#include <plane_instance.h>
+#include <space_instance.h>
+#include <region.h>
+
+#include "SolidPool.h"
+
+// Calls work(order[0]), work(order[1]), ... on native threads, handing out items in the
+// given order. Put the most expensive items first so the slowest ones don't end up last.
+template <typename Work>
+void ParallelFor(const std::vector<size_t> &order, Work work)
+{
+    const size_t count = order.size();
+    std::atomic<size_t> next(0);
+    auto loop = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+            work(order[i]);
+    };
+
+    size_t threadCount = std::thread::hardware_concurrency();
+    if (threadCount > count)
+        threadCount = count;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; t++)
+        threads.push_back(std::thread(loop));
+    loop();
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+}
+
+// Process-wide cache of face grids, so that faces which survive an operation unchanged (or are
+// re-meshed at a precision seen before) aren't tessellated again. Entries are evicted least
+// recently used first once the (approximate) size of the cached grids exceeds the budget.
+class GridCache
+{
+public:
+    struct Stats
+    {
+        size_t hits, misses, evictions, entries, bytes, budget;
+    };
+
+    static GridCache &Instance();
+    // Identifies the face's geometry (not the face object) together with the tessellation parameters; see the definition
+    // for what two faces sharing a key have in common.
+    static uint64_t Key(const MbFace &face, const MbStepData &stepData, const MbFormNote &formNote);
+
+    // Returns a copy of the cached grid, or NULL on a miss.
+    MbGrid *Get(uint64_t key);
+    // The cached grid itself (AddRef'd; Release it), or NULL. Counts as neither a hit nor a use.
+    MbGrid *Find(uint64_t key);
+    void Put(uint64_t key, const MbGrid &grid);
+    void SetBudget(size_t bytes);
+    void Clear();
+    Stats GetStats();
+
+    // Hashes everything about the solid that is saved to a file, so that it matches exactly the same solid once reopened.
+    static uint64_t ItemHash(const MbSolid &solid);
+    // Sets aside the (keyed, AddRef'd) grids read for a solid whose ItemHash was item; see Claim.
+    void Stash(uint64_t item, size_t faceCount, std::vector<std::pair<uint64_t, MbGrid *>> &grids);
+    // Moves the grids stashed for this very solid, if any, into the cache. The solid is only hashed when
+    // something with as many faces is stashed, so this is cheap once everything reopened has been displayed.
+    void Claim(const MbSolid &solid);
+
+private:
+    GridCache();
+    void Evict();
+
+    struct Stashed
+    {
+        uint64_t item;
+        size_t faceCount;
+        std::vector<std::pair<uint64_t, MbGrid *>> grids;
+    };
+
+    struct Entry
+    {
+        MbGrid *grid;
+        size_t bytes;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    std::mutex mutex;
+    std::list<uint64_t> lru;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::vector<Stashed> stashed;
+    size_t budget, bytes, hits, misses, evictions;
+};
+
+// Process-wide pool of grids handed back by JS (see MeshBufferPool.Recycle), so that re-tessellating, say, a
+// temporary solid on every frame of a drag writes into storage that has grown to size already. A grid is only
+// reused once the pool holds the last reference to it: JS views over its memory pin it (see getPinnedBuffer).
+class GridPool
+{
+public:
+    static GridPool &Instance();
+
+    void Put(MbGrid &grid);
+    // An empty grid (still referenced by the pool; add it to a mesh and then Release it), or NULL.
+    MbGrid *Take();
+    void Clear();
+    size_t Count();
+
+private:
+    GridPool() {}
+
+    std::mutex mutex;
+    std::vector<MbGrid *> grids;
+};
+
+class SolidTessellator;
+
+// One face or edge to tessellate; size orders the work (largest first).
+struct TessellationJob
+{
+    SolidTessellator *tessellator;
+    size_t k;
+    double size;
+};
+
+// Tessellates every face and edge of a solid in one go. The faces go into a single mesh with one grid
+// per face (in face order); each edge gets its own mesh, as with MbCurveEdge::CalculateMesh.
+// Only with cache is the GridCache, which is meant for committed geometry, read from and added to.
+class SolidTessellator
+{
+public:
+    SolidTessellator(const MbSolid &solid, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly, bool cache = false);
+    virtual ~SolidTessellator();
+
+    bool Calculate();
+    virtual Napi::Object ToJs(const Napi::Env env);
+
+    // Calculate() is Prepare(), Run() for each job, then Finish(); several tessellators can share one pass.
+    void Prepare(std::vector<TessellationJob> &jobs);
+    void Run(size_t k);
+    bool Finish();
+    static void RunAll(std::vector<TessellationJob> &jobs);
+
+protected:
+    // Called on the worker thread as soon as job k is done
+    virtual void Ran(size_t k) {}
+    // The first displayed polygon of edge i, as in ToJs; false if there is none
+    bool EdgeToJs(const Napi::Env env, size_t i, Napi::Object &result);
+
+    const MbSolid &solid;
+    const MbStepData stepData;
+    const MbFormNote formNote;
+    const bool outlinesOnly;
+    const bool cache;
+
+    MbMesh *mesh;
+    RPArray<MbFace> faces;
+    RPArray<MbCurveEdge> edges;
+    // Faces and edges marked here are neither tessellated nor returned by ToJs
+    std::vector<bool> skipFaces;
+    std::vector<bool> skipEdges;
+    // The face index of each grid in mesh, and the edge index of each edge returned by ToJs
+    std::vector<size_t> gridFaces;
+    std::vector<size_t> edgeIndices;
+    std::vector<MbMesh *> edgeMeshes;
+    // Per face/edge precisions; when empty, stepData is used for everything
+    std::vector<MbStepData> faceStepDatas;
+    std::vector<MbStepData> edgeStepDatas;
+
+    // GRID_BOUNDS_STRIDE floats per face, filled in as each face is done
+    std::vector<float> faceBounds;
+
+private:
+    const MbStepData &FaceStepData(size_t i) const { return faceStepDatas.empty() ? stepData : faceStepDatas[i]; }
+    const MbStepData &EdgeStepData(size_t i) const { return edgeStepDatas.empty() ? stepData : edgeStepDatas[i]; }
+
+    std::vector<MbGrid *> grids;
+    std::vector<uint64_t> keys;
+    std::vector<bool> cached;
+    std::atomic<bool> failed;
+};
+
+// Runs several tessellators in a single parallel pass; ToJs returns an array with one result per tessellator.
+class TessellatorGroup
+{
+public:
+    virtual ~TessellatorGroup();
+
+    bool Calculate();
+    Napi::Object ToJs(const Napi::Env env);
+
+protected:
+    std::vector<SolidTessellator *> members;
+};
+
+// Tessellates a solid at several precisions (coarsest first, say) in a single parallel pass.
+class SolidLevelsTessellator : public TessellatorGroup
+{
+public:
+    SolidLevelsTessellator(const MbSolid &solid, const std::vector<MbStepData> &stepDatas, const MbFormNote &formNote, bool outlinesOnly, bool cache);
+};
+
+// Everything in model units. fov is the vertical field of view in radians, or 0 for an orthographic
+// camera whose visible height is height.
+struct ViewCamera
+{
+    MbCartPoint3D eye;
+    MbVector3D direction;
+    double fov, height;
+    double viewportHeight, pixelError;
+    double minSag, maxSag;
+
+    // The sag at which a tessellation of something inside cube deviates by at most pixelError pixels on screen.
+    double Sag(const MbCube &cube) const;
+};
+
+// Tessellates each face and edge at the precision its projected size calls for: nearby faces finely,
+// distant ones coarsely.
+class ViewSolidTessellator : public SolidTessellator
+{
+public:
+    ViewSolidTessellator(const MbSolid &solid, const ViewCamera &camera, const MbFormNote &formNote, bool outlinesOnly);
+};
+
+class ViewTessellator : public TessellatorGroup
+{
+public:
+    ViewTessellator(const std::vector<const MbSolid *> &solids, const ViewCamera &camera, const MbFormNote &formNote, bool outlinesOnly);
+};
+
+class StreamingTessellator;
+void CallStream(Napi::Env env, Napi::Function callback, StreamingTessellator *context, size_t *data);
+using STREAM = Napi::TypedThreadSafeFunction<StreamingTessellator, size_t, CallStream>;
+
+// Tessellates a solid on a background thread. Whatever faces and edges are done get handed to the listener's
+// batch(faces, edges) on the main thread, then done(success) is called and the promise, if any, settled.
+// It deletes itself once the listener is called for the last time.
+class StreamingTessellator : public SolidTessellator
+{
+public:
+    static void Start(const Napi::Env env, const MbSolid &solid, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly, const Napi::Object listener, const Napi::Promise::Deferred *deferred = NULL);
+    virtual ~StreamingTessellator();
+
+    void Flush(const Napi::Env env, bool done);
+
+protected:
+    void Ran(size_t k) override;
+
+private:
+    StreamingTessellator(const MbSolid &solid, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly, const Napi::Object listener, const Napi::Promise::Deferred *deferred);
+    void Stream();
+    void Push(size_t k);
+
+    Napi::ObjectReference listener;
+    Napi::Promise::Deferred *deferred;
+    STREAM stream;
+    std::thread thread;
+    // The grid index of each face
+    std::unordered_map<size_t, size_t> faceGrids;
+    // Faces and edges that are done but not yet handed to the listener
+    std::mutex mutex;
+    std::vector<size_t> pending;
+    bool success;
+};
+
+// Quickly tessellates a solid at a coarse precision; once that is handed to JS, the fine precision
+// follows through a StreamingTessellator.
+class ProgressiveTessellator
+{
+public:
+    ProgressiveTessellator(const MbSolid &solid, const MbStepData &coarseStepData, const MbStepData &fine, const MbFormNote &formNote, bool outlinesOnly, const Napi::Object listener);
+
+    bool Calculate();
+    // NOTE: also starts the refinement
+    Napi::Object ToJs(const Napi::Env env);
+
+private:
+    SolidTessellator coarse;
+    const MbSolid &solid;
+    const MbStepData fine;
+    const MbFormNote formNote;
+    const bool outlinesOnly;
+    Napi::ObjectReference listener;
+};
+
+// Tessellates a solid once for all the copies a duplication would make; ToJs adds their transforms so
+// that they can be drawn as instances of the one tessellation.
+class InstancedTessellator : public SolidTessellator
+{
+public:
+    InstancedTessellator(const MbSolid &solid, const DuplicationValues &params, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly);
+
+    Napi::Object ToJs(const Napi::Env env) override;
+
+private:
+    std::vector<MbMatrix3D> matrices;
+};
+
+// Triangulates regions lying on one placement in parallel, as MbPlaneInstance::CalculateMesh would one by one.
+// ToJs packs them all into one buffer (see RegionTessellation.Tessellate).
+class RegionTessellator
+{
+public:
+    RegionTessellator(const std::vector<const MbRegion *> &regions, const MbPlacement3D &placement, const MbStepData &stepData, const MbFormNote &formNote);
+    ~RegionTessellator();
+
+    bool Calculate();
+    Napi::Object ToJs(const Napi::Env env);
+
+private:
+    const MbStepData stepData;
+    const MbFormNote formNote;
+    std::vector<MbPlaneInstance *> instances;
+    std::vector<MbMesh *> meshes;
+    // The total number of contour segments of each region, a rough measure of the work
+    std::vector<size_t> sizes;
+};
+
+// Samples the display polylines of many curves (as MbSpaceInstance::CalculateMesh would one by one) in parallel.
+// ToJs packs them all into one buffer (see CurveTessellation.Tessellate).
+class CurveTessellator
+{
+public:
+    CurveTessellator(const std::vector<const MbSpaceInstance *> &instances, const MbStepData &stepData, const MbFormNote &formNote);
+    ~CurveTessellator();
+
+    bool Calculate();
+    Napi::Object ToJs(const Napi::Env env);
+
+private:
+    const MbStepData stepData;
+    const MbFormNote formNote;
+    std::vector<const MbSpaceInstance *> instances;
+    std::vector<MbMesh *> meshes;
+};
+
+// Packs the grids of the faces of solids at each precision, keyed as in GridCache, into one buffer; grids the
+// GridCache has are copied and the rest are tessellated (without being cached). The grids are grouped by solid
+// under its ItemHash, and GridChunkReader only stashes them: they reach the cache once a solid with the very same
+// content is tessellated, so a file saved along with the buffer reopens without re-meshing but a stale grid never
+// gets used, however similar its face.
+class GridChunkWriter
+{
+public:
+    GridChunkWriter(const std::vector<const MbSolid *> &solids, const std::vector<MbStepData> &stepDatas, const MbFormNote &formNote);
+    ~GridChunkWriter();
+
+    bool Calculate();
+    Napi::Value ToJs(const Napi::Env env);
+
+private:
+    std::vector<const MbSolid *> solids;
+    const std::vector<MbStepData> stepDatas;
+    const MbFormNote formNote;
+    char *data;
+    size_t length;
+};
+
+class GridChunkReader
+{
+public:
+    GridChunkReader(const Napi::Buffer<char> buffer);
+
+    // False if the buffer isn't a (complete) grid chunk; whatever solids were read in full are stashed regardless.
+    // A chunk of another version stashes nothing.
+    // Reading stops once the grids read would fill the cache's budget, which is never raised.
+    bool Calculate();
+    // The number of grids stashed
+    Napi::Value ToJs(const Napi::Env env);
+
+private:
+    // Kept alive until the grids are read
+    Napi::ObjectReference buffer;
+    const char *data;
+    const size_t length;
+    size_t loaded;
+};
+
+// Re-tessellates a solid made by an operation on a SolidPool copy. Faces and edges the operation didn't
+// change are mapped back to the original solid through the copy's history; if the caller already has
+// buffers for those originals (the known ids) they are skipped and reported as reused instead.
+class IncrementalTessellator : public SolidTessellator
+{
+public:
+    IncrementalTessellator(const MbSolid &solid, const std::vector<const SolidDuplicate *> &histories, const std::unordered_set<uint64_t> &knownFaces, const std::unordered_set<uint64_t> &knownEdges, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly);
+
+    Napi::Object ToJs(const Napi::Env env) override;
+
+private:
+    // The id of the original of each face/edge, or 0 if it changed
+    std::vector<uint64_t> faceIds;
+    std::vector<uint64_t> edgeIds;
+    std::vector<uint64_t> removedFaceIds;
+    std::vector<uint64_t> removedEdgeIds;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include <algorithm>
+
+#include "../include/CurveIntersectionAddon.h"
+#include "../include/CurveIntersection.h"
+#include "../include/Curve3D.h"
+#include "../include/PromiseWorker.h"
+#include "../include/TessellationAddon.h"
+
+#include "action_point.h"
+#include "tool_mutex.h"
+
+CurveIntersector::CurveIntersector(const std::vector<const MbCurve3D *> &curves_, const std::vector<const MbCurve3D *> &others, double mEps)
+    : count(curves_.size()), curves(curves_), mEps(mEps)
+{
+    curves.insert(curves.end(), others.begin(), others.end());
+    for (size_t i = 0; i < curves.size(); i++)
+        curves[i]->AddRef();
+}
+
+CurveIntersector::~CurveIntersector()
+{
+    for (size_t i = 0; i < curves.size(); i++)
+        curves[i]->Release();
+}
+
+// Sweep and prune: with the boxes sorted by their lower x, each box need only be checked against the boxes that
+// begin before it ends.
+void CurveIntersector::Candidates()
+{
+    const size_t total = curves.size();
+    std::vector<MbCube> cubes(total);
+    std::vector<size_t> order(total);
+    for (size_t i = 0; i < total; i++)
+    {
+        order[i] = i;
+        curves[i]->AddYourGabaritTo(cubes[i]);
+    }
+    std::sort(order.begin(), order.end(), [&cubes](size_t a, size_t b)
+              { return cubes[a].pmin.x < cubes[b].pmin.x; });
+
+    for (size_t m = 0; m < total; m++)
+    {
+        const size_t a = order[m];
+        const MbCube &ca = cubes[a];
+        if (ca.IsEmpty())
+            continue;
+        for (size_t n = m + 1; n < total; n++)
+        {
+            const size_t b = order[n];
+            const MbCube &cb = cubes[b];
+            if (cb.pmin.x > ca.pmax.x + mEps)
+                break;
+            // Two of the others never need intersecting
+            if ((a >= count && b >= count) || cb.IsEmpty())
+                continue;
+            if (cb.pmin.y > ca.pmax.y + mEps || ca.pmin.y > cb.pmax.y + mEps)
+                continue;
+            if (cb.pmin.z > ca.pmax.z + mEps || ca.pmin.z > cb.pmax.z + mEps)
+                continue;
+            candidates.push_back(std::make_pair((uint32_t)std::min(a, b), (uint32_t)std::max(a, b)));
+        }
+    }
+    // The same pairs in the same order, whatever order the sweep found them in
+    std::sort(candidates.begin(), candidates.end());
+}
+
+bool CurveIntersector::Calculate()
+{
+    Candidates();
+    const size_t pairCount = candidates.size();
+    params1.resize(pairCount);
+    params2.resize(pairCount);
+
+    std::vector<size_t> order(pairCount);
+    for (size_t k = 0; k < pairCount; k++)
+        order[k] = k;
+
+    std::atomic<bool> failed(false);
+    EnterParallelRegion();
+    ParallelFor(order, [&](size_t k)
+                {
+                    try
+                    {
+                        SArray<double> result1, result2;
+                        const ptrdiff_t n = ::CurveCurveIntersection(*curves[candidates[k].first], *curves[candidates[k].second], result1, result2, mEps);
+                        for (ptrdiff_t i = 0; i < n; i++)
+                        {
+                            params1[k].push_back(result1[i]);
+                            params2[k].push_back(result2[i]);
+                        }
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                    }
+                });
+    ExitParallelRegion();
+    return !failed;
+}
+
+Napi::Object CurveIntersector::ToJs(const Napi::Env env)
+{
+    size_t crossCount = 0;
+    for (size_t k = 0; k < params1.size(); k++)
+        crossCount += params1[k].size();
+
+    Napi::Uint32Array pairs = Napi::Uint32Array::New(env, 2 * crossCount);
+    Napi::Float64Array params = Napi::Float64Array::New(env, 2 * crossCount);
+    size_t row = 0;
+    for (size_t k = 0; k < params1.size(); k++)
+        for (size_t i = 0; i < params1[k].size(); i++, row++)
+        {
+            pairs[2 * row] = candidates[k].first;
+            pairs[2 * row + 1] = candidates[k].second;
+            params[2 * row] = params1[k][i];
+            params[2 * row + 1] = params2[k][i];
+        }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "pairs"), pairs);
+    result.Set(Napi::String::New(env, "params"), params);
+    return result;
+}
+
+class Intersect_AsyncWorker : public PromiseWorker
+{
+public:
+    Intersect_AsyncWorker(Napi::Promise::Deferred const &d, CurveIntersector *intersector)
+        : PromiseWorker(d), intersector(intersector) {}
+    virtual ~Intersect_AsyncWorker() { delete intersector; }
+
+    void Execute() override
+    {
+        if (!intersector->Calculate())
+            SetError("Operation Intersect failed");
+    }
+
+    void Resolve(Napi::Promise::Deferred const &deferred) override
+    {
+        deferred.Resolve(intersector->ToJs(deferred.Env()));
+    }
+
+    void Reject(Napi::Promise::Deferred const &deferred, Napi::Error const &error) override
+    {
+        error.Value()["isC3dError"] = true;
+        deferred.Reject(error.Value());
+    }
+
+private:
+    CurveIntersector *intersector;
+};
+
+static bool getCurves(const Napi::Env env, const Napi::Value value, const char *message, std::vector<const MbCurve3D *> &result)
+{
+    if (!value.IsArray())
+    {
+        Napi::Error::New(env, message).ThrowAsJavaScriptException();
+        return false;
+    }
+    const Napi::Array curves = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < curves.Length(); i++)
+    {
+        const Napi::Value curve = curves[i];
+        if (!(curve.IsObject() && curve.ToObject().InstanceOf(Curve3D::GetConstructor(env))))
+        {
+            Napi::Error::New(env, message).ThrowAsJavaScriptException();
+            return false;
+        }
+        result.push_back(Curve3D::Unwrap(curve.ToObject())->_underlying);
+    }
+    return true;
+}
+
+static CurveIntersector *newCurveIntersector(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3)
+    {
+        Napi::Error::New(env, "Expecting 3 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<const MbCurve3D *> curves, others;
+    if (!getCurves(env, info[0], "Curve3D[] curves is required.", curves))
+        return NULL;
+    if (!getCurves(env, info[1], "Curve3D[] others is required.", others))
+        return NULL;
+    if (!info[2].IsNumber())
+    {
+        Napi::Error::New(env, "double mEps is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    return new CurveIntersector(curves, others, info[2].ToNumber().DoubleValue());
+}
+
+Napi::Value CurveIntersection::Intersect(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    CurveIntersector *intersector = newCurveIntersector(info);
+    if (intersector == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (intersector->Calculate())
+        result = intersector->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Intersect failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete intersector;
+    return result;
+}
+
+Napi::Value CurveIntersection::Intersect_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    CurveIntersector *intersector = newCurveIntersector(info);
+    if (intersector == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Intersect_AsyncWorker *asyncWorker = new Intersect_AsyncWorker(deferred, intersector);
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
@@ -1,8 +1,46 @@
+#include "../include/MeshAddon.h"
 #include "../include/Name.h"
 #include "../include/CurveEdge.h"
 #include "../include/Face.h"
 #include "../include/Solid.h"
 #include "../include/Grid.h"
+#include "../include/Mesh.h"
+
+struct PinnedGrid
+{
+    const MbGrid *grid;
+    const MbMesh *mesh;
+};
+
+Napi::ArrayBuffer getPinnedBuffer(const Napi::Env env, const void *data, size_t bytes, const MbGrid *grid, const MbMesh *mesh)
+{
+    grid->AddRef();
+    if (mesh != NULL)
+        mesh->AddRef();
+    PinnedGrid *pin = new PinnedGrid();
+    pin->grid = grid;
+    pin->mesh = mesh;
+    return Napi::ArrayBuffer::New(env, (void *)data, bytes, [](Napi::Env, void *, PinnedGrid *pin)
+                                  {
+                                      pin->grid->Release();
+                                      if (pin->mesh != NULL)
+                                          pin->mesh->Release();
+                                      delete pin; },
+                                  pin);
+}
+
+Napi::TypedArray getIndex(const Napi::Env env, const MbGrid *grid, const MbMesh *mesh)
+{
+    const size_t count = 3 * grid->TrianglesCount();
+    if (grid->PointsCount() <= SHORT_INDEX_LIMIT)
+    {
+        Napi::Uint16Array index = Napi::Uint16Array::New(env, count);
+        copyIndex(index.Data(), (const uint32_t *)grid->GetTrianglesAddr(), count, 0);
+        return index;
+    }
+    Napi::ArrayBuffer tbuf = getPinnedBuffer(env, grid->GetTrianglesAddr(), sizeof(MbTriangle) * grid->TrianglesCount(), grid, mesh);
+    return Napi::Uint32Array::New(env, count, tbuf, 0);
+}
 
 Napi::Value Grid::GetBuffers_async(const Napi::CallbackInfo &info)
 {
@@ -15,11 +53,10 @@ Napi::Value Grid::GetBuffers(const Napi::CallbackInfo &info)
 
     Napi::Env env = info.Env();
     Napi::Object result = Napi::Object::New(env);
-    Napi::ArrayBuffer tbuf = Napi::ArrayBuffer::New(env, (void *)underlying->GetTrianglesAddr(), sizeof(MbTriangle) * underlying->TrianglesCount());
-    Napi::Uint32Array index = Napi::Uint32Array::New(env, 3 * underlying->TrianglesCount(), tbuf, 0);
-    Napi::ArrayBuffer pbuf = Napi::ArrayBuffer::New(env, (void *)underlying->GetFloatPointsAddr(), sizeof(MbFloatPoint3D) * underlying->PointsCount());
+    Napi::TypedArray index = getIndex(env, underlying);
+    Napi::ArrayBuffer pbuf = getPinnedBuffer(env, underlying->GetFloatPointsAddr(), sizeof(MbFloatPoint3D) * underlying->PointsCount(), underlying, NULL);
     Napi::Float32Array position = Napi::Float32Array::New(env, 3 * underlying->PointsCount(), pbuf, 0);
-    Napi::ArrayBuffer nbuf = Napi::ArrayBuffer::New(env, (void *)underlying->GetFloatNormalsAddr(), sizeof(MbFloatPoint3D) * underlying->PointsCount());
+    Napi::ArrayBuffer nbuf = getPinnedBuffer(env, underlying->GetFloatNormalsAddr(), sizeof(MbFloatPoint3D) * underlying->PointsCount(), underlying, NULL);
     Napi::Float32Array normal = Napi::Float32Array::New(env, 3 * underlying->NormalsCount(), nbuf, 0);
 
     result.Set(Napi::String::New(env, "index"), index);
@@ -29,15 +66,153 @@ Napi::Value Grid::GetBuffers(const Napi::CallbackInfo &info)
     return result;
 }
 
-Napi::Object getBuffer(const Napi::CallbackInfo &info, const size_t i, MbGrid *grid)
+void getGridBounds(const MbGrid &grid, float *result)
+{
+    const size_t pointsCount = grid.PointsCount();
+    const size_t normalsCount = grid.NormalsCount();
+    const float *points = (const float *)grid.GetFloatPointsAddr();
+    const float *normals = (const float *)grid.GetFloatNormalsAddr();
+
+    float *min = result, *max = result + 3, *axis = result + 6;
+    for (size_t c = 0; c < 3; c++)
+        min[c] = max[c] = pointsCount > 0 ? points[c] : 0;
+    for (size_t j = 1; j < pointsCount; j++)
+        for (size_t c = 0; c < 3; c++)
+        {
+            const float v = points[3 * j + c];
+            min[c] = std::min(min[c], v);
+            max[c] = std::max(max[c], v);
+        }
+
+    // The axis is the mean normal; the half-angle is the widest angle between it and any normal.
+    double sum[3] = {0, 0, 0};
+    for (size_t j = 0; j < normalsCount; j++)
+        for (size_t c = 0; c < 3; c++)
+            sum[c] += normals[3 * j + c];
+    const double length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+    if (length < 1e-6)
+    {
+        axis[0] = axis[1] = axis[2] = 0;
+        result[9] = std::acos(-1.0f);
+        return;
+    }
+    for (size_t c = 0; c < 3; c++)
+        axis[c] = (float)(sum[c] / length);
+
+    float minCos = 1;
+    for (size_t j = 0; j < normalsCount; j++)
+    {
+        const float *n = normals + 3 * j;
+        const float l = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (l == 0)
+            continue;
+        minCos = std::min(minCos, (n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]) / l);
+    }
+    result[9] = std::acos(std::max(-1.0f, std::min(1.0f, minCos)));
+}
+
+static inline int16_t toSnorm16(float v)
+{
+    v = std::max(-1.0f, std::min(1.0f, v));
+    return (int16_t)(v * 32767.0f + (v >= 0 ? 0.5f : -0.5f));
+}
+
+void getQuantizedBuffer(const Napi::Env env, const MbGrid *grid, Napi::Object &result)
+{
+    const size_t pointsCount = grid->PointsCount();
+    const size_t normalsCount = std::min(pointsCount, grid->NormalsCount());
+    const float *points = (const float *)grid->GetFloatPointsAddr();
+    const float *normals = (const float *)grid->GetFloatNormalsAddr();
+
+    float min[3] = {0, 0, 0}, extent[3] = {0, 0, 0};
+    if (pointsCount > 0)
+    {
+        float max[3];
+        for (size_t c = 0; c < 3; c++)
+            min[c] = max[c] = points[c];
+        for (size_t j = 1; j < pointsCount; j++)
+            for (size_t c = 0; c < 3; c++)
+            {
+                const float v = points[3 * j + c];
+                min[c] = std::min(min[c], v);
+                max[c] = std::max(max[c], v);
+            }
+        for (size_t c = 0; c < 3; c++)
+            extent[c] = max[c] - min[c];
+    }
+
+    // Positions and normals share one ArrayBuffer: [position u16 3P | normal i16 2P]
+    const size_t normalOffset = sizeof(uint16_t) * 3 * pointsCount;
+    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, normalOffset + sizeof(int16_t) * 2 * pointsCount);
+    uint8_t *data = (uint8_t *)buf.Data();
+    uint16_t *position = (uint16_t *)data;
+    int16_t *normal = (int16_t *)(data + normalOffset);
+
+    for (size_t j = 0; j < pointsCount; j++)
+        for (size_t c = 0; c < 3; c++)
+        {
+            const float t = extent[c] > 0 ? (points[3 * j + c] - min[c]) / extent[c] : 0;
+            position[3 * j + c] = (uint16_t)(std::max(0.0f, std::min(1.0f, t)) * 65535.0f + 0.5f);
+        }
+
+    // Octahedral encoding: project onto the octahedron |x|+|y|+|z|=1 and fold the lower hemisphere over.
+    for (size_t j = 0; j < normalsCount; j++)
+    {
+        float x = normals[3 * j + 0], y = normals[3 * j + 1], z = normals[3 * j + 2];
+        const float l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        if (l1 > 0)
+        {
+            x /= l1;
+            y /= l1;
+            z /= l1;
+        }
+        if (z < 0)
+        {
+            const float fx = (1 - std::fabs(y)) * (x >= 0 ? 1 : -1);
+            const float fy = (1 - std::fabs(x)) * (y >= 0 ? 1 : -1);
+            x = fx;
+            y = fy;
+        }
+        normal[2 * j + 0] = toSnorm16(x);
+        normal[2 * j + 1] = toSnorm16(y);
+    }
+    memset(normal + 2 * normalsCount, 0, sizeof(int16_t) * 2 * (pointsCount - normalsCount));
+
+    Napi::Float32Array offset = Napi::Float32Array::New(env, 3);
+    Napi::Float32Array scale = Napi::Float32Array::New(env, 3);
+    for (size_t c = 0; c < 3; c++)
+    {
+        offset[c] = min[c];
+        scale[c] = extent[c];
+    }
+
+    result.Set(Napi::String::New(env, "index"), getIndex(env, grid));
+    result.Set(Napi::String::New(env, "position"), Napi::Uint16Array::New(env, 3 * pointsCount, buf, 0));
+    result.Set(Napi::String::New(env, "normal"), Napi::Int16Array::New(env, 2 * pointsCount, buf, normalOffset));
+    result.Set(Napi::String::New(env, "offset"), offset);
+    result.Set(Napi::String::New(env, "scale"), scale);
+}
+
+Napi::Value Grid::GetQuantizedBuffers_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value Grid::GetQuantizedBuffers(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
     Napi::Object result = Napi::Object::New(env);
-    Napi::ArrayBuffer tbuf = Napi::ArrayBuffer::New(env, (void *)grid->GetTrianglesAddr(), sizeof(MbTriangle) * grid->TrianglesCount());
-    Napi::Uint32Array index = Napi::Uint32Array::New(env, 3 * grid->TrianglesCount(), tbuf, 0);
-    Napi::ArrayBuffer pbuf = Napi::ArrayBuffer::New(env, (void *)grid->GetFloatPointsAddr(), sizeof(MbFloatPoint3D) * grid->PointsCount());
+    getQuantizedBuffer(env, _underlying, result);
+    return result;
+}
+
+Napi::Object getBuffer(const Napi::Env env, const size_t i, MbGrid *grid, const MbMesh *mesh)
+{
+    Napi::Object result = Napi::Object::New(env);
+    Napi::TypedArray index = getIndex(env, grid, mesh);
+    Napi::ArrayBuffer pbuf = getPinnedBuffer(env, grid->GetFloatPointsAddr(), sizeof(MbFloatPoint3D) * grid->PointsCount(), grid, mesh);
     Napi::Float32Array position = Napi::Float32Array::New(env, 3 * grid->PointsCount(), pbuf, 0);
-    Napi::ArrayBuffer nbuf = Napi::ArrayBuffer::New(env, (void *)grid->GetFloatNormalsAddr(), sizeof(MbFloatPoint3D) * grid->PointsCount());
+    Napi::ArrayBuffer nbuf = getPinnedBuffer(env, grid->GetFloatNormalsAddr(), sizeof(MbFloatPoint3D) * grid->PointsCount(), grid, mesh);
     Napi::Float32Array normal = Napi::Float32Array::New(env, 3 * grid->NormalsCount(), nbuf, 0);
 
     // TODO: test if Napi::String::New is expensive
@@ -80,46 +255,650 @@ Napi::Value Mesh::GetBuffers(const Napi::CallbackInfo &info)
             {
                 if (!grid->IsVisible())
                     continue;
-                result[j++] = getBuffer(info, i, grid);
+                result[j++] = getBuffer(env, i, grid, mesh);
             }
         }
     }
     return result;
 }
 
-Napi::Value Mesh::GetApexes_async(const Napi::CallbackInfo &info)
+Napi::Value Mesh::GetQuantizedBuffers_async(const Napi::CallbackInfo &info)
 {
     return info.Env().Undefined();
 }
 
-Napi::Value Mesh::GetApexes(const Napi::CallbackInfo &info)
+Napi::Value Mesh::GetQuantizedBuffers(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
     MbMesh *mesh = _underlying;
-    size_t count = mesh->ApexesCount();
-    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, 4 * 3 * count);
-    Napi::Float32Array result = Napi::Float32Array::New(env, 3 * count, buf, 0);
-    if (count > 0)
+    Napi::Array result = Napi::Array::New(env);
+    for (size_t i = 0, j = 0, iCount = mesh->GridsCount(); i < iCount; i++)
     {
-        MbCartPoint3D p;
-        size_t i = 0;
-        for (size_t k = 0; k < count; k++)
+        MbGrid *grid = mesh->SetGrid(i);
+        if (grid == NULL || !grid->IsVisible())
+            continue;
+
+        Napi::Object jsInfo = Napi::Object::New(env);
+        getQuantizedBuffer(env, grid, jsInfo);
+        jsInfo.Set(Napi::String::New(env, "style"), Napi::Number::New(env, grid->GetStyle()));
+        jsInfo.Set(Napi::String::New(env, "simpleName"), Napi::Number::New(env, grid->GetPrimitiveName()));
+        jsInfo.Set(Napi::String::New(env, "i"), Napi::Number::New(env, i));
+        result[j++] = jsInfo;
+    }
+    return result;
+}
+
+Napi::Object getPackedBuffers(const Napi::Env env, const std::vector<std::pair<size_t, const MbGrid *>> &grids)
+{
+    size_t indexCount = 0, pointsCount = 0;
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        indexCount += 3 * grids[g].second->TrianglesCount();
+        pointsCount += grids[g].second->PointsCount();
+    }
+
+    // Everything lives in a single ArrayBuffer: [index | position | normal | groups]
+    const bool shortIndex = pointsCount <= SHORT_INDEX_LIMIT;
+    const size_t indexSize = shortIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+    const size_t groupsCount = PACKED_GROUP_STRIDE * grids.size();
+    const size_t positionOffset = (indexSize * indexCount + 3) & ~(size_t)3;
+    const size_t normalOffset = positionOffset + sizeof(float) * 3 * pointsCount;
+    const size_t groupsOffset = normalOffset + sizeof(float) * 3 * pointsCount;
+    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, groupsOffset + sizeof(uint32_t) * groupsCount);
+    uint8_t *data = (uint8_t *)buf.Data();
+    float *position = (float *)(data + positionOffset);
+    float *normal = (float *)(data + normalOffset);
+    uint32_t *groups = (uint32_t *)(data + groupsOffset);
+
+    size_t indexOffset = 0, pointOffset = 0;
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        const MbGrid *grid = grids[g].second;
+        const size_t count = 3 * grid->TrianglesCount();
+        const size_t points = grid->PointsCount();
+        const size_t normals = std::min(points, grid->NormalsCount());
+
+        const uint32_t *triangles = (const uint32_t *)grid->GetTrianglesAddr();
+        if (shortIndex)
+            copyIndex((uint16_t *)data + indexOffset, triangles, count, pointOffset);
+        else
+            copyIndex((uint32_t *)data + indexOffset, triangles, count, pointOffset);
+        memcpy(position + 3 * pointOffset, grid->GetFloatPointsAddr(), sizeof(MbFloatPoint3D) * points);
+        memcpy(normal + 3 * pointOffset, grid->GetFloatNormalsAddr(), sizeof(MbFloatPoint3D) * normals);
+        memset(normal + 3 * (pointOffset + normals), 0, sizeof(MbFloatPoint3D) * (points - normals));
+
+        uint32_t *group = groups + PACKED_GROUP_STRIDE * g;
+        group[0] = (uint32_t)indexOffset;
+        group[1] = (uint32_t)count;
+        group[2] = (uint32_t)grids[g].first;
+        group[3] = (uint32_t)grid->GetStyle();
+        group[4] = (uint32_t)grid->GetPrimitiveName();
+
+        indexOffset += count;
+        pointOffset += points;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    if (shortIndex)
+        result.Set(Napi::String::New(env, "index"), Napi::Uint16Array::New(env, indexCount, buf, 0));
+    else
+        result.Set(Napi::String::New(env, "index"), Napi::Uint32Array::New(env, indexCount, buf, 0));
+    result.Set(Napi::String::New(env, "position"), Napi::Float32Array::New(env, 3 * pointsCount, buf, positionOffset));
+    result.Set(Napi::String::New(env, "normal"), Napi::Float32Array::New(env, 3 * pointsCount, buf, normalOffset));
+    result.Set(Napi::String::New(env, "groups"), Napi::Uint32Array::New(env, groupsCount, buf, groupsOffset));
+    return result;
+}
+
+Napi::Value Mesh::GetPackedBuffers_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value Mesh::GetPackedBuffers(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    MbMesh *mesh = _underlying;
+    std::vector<std::pair<size_t, const MbGrid *>> grids;
+    for (size_t i = 0, iCount = mesh->GridsCount(); i < iCount; i++)
+    {
+        const MbGrid *grid = mesh->GetGrid(i);
+        if (grid == NULL || !grid->IsVisible())
+            continue;
+        grids.push_back(std::make_pair(i, grid));
+    }
+    return getPackedBuffers(env, grids);
+}
+
+static inline uint64_t weldCell(int64_t x, int64_t y, int64_t z)
+{
+    return ((uint64_t)x * 73856093ULL) ^ ((uint64_t)y * 19349663ULL) ^ ((uint64_t)z * 83492791ULL);
+}
+
+// Welds the vertices of the grids (see getWeldedBuffers); remaps[g][j] is the welded vertex of point j of grid g.
+static void weldVertices(const std::vector<std::pair<size_t, const MbGrid *>> &grids, double tolerance, float minCos, std::vector<float> &position, std::vector<float> &normal, std::vector<std::vector<uint32_t>> &remaps)
+{
+    const float cellSize = (float)std::max(tolerance, 1e-9);
+    const float tolerance2 = (float)(tolerance * tolerance);
+
+    // Welded vertices are chained per hash cell: head[cell] -> next[w] -> ...
+    std::unordered_map<uint64_t, uint32_t> head;
+    std::vector<uint32_t> next;
+    remaps.resize(grids.size());
+    const uint32_t none = (uint32_t)-1;
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        const MbGrid *grid = grids[g].second;
+        const size_t points = grid->PointsCount();
+        const size_t normals = std::min(points, grid->NormalsCount());
+        const float *p = (const float *)grid->GetFloatPointsAddr();
+        const float *n = (const float *)grid->GetFloatNormalsAddr();
+        std::vector<uint32_t> &remap = remaps[g];
+        remap.resize(points);
+        for (size_t j = 0; j < points; j++)
         {
-            const MbApex3D *apex = mesh->GetApex(k);
-            if (apex == NULL)
+            const float *pj = p + 3 * j;
+            const float zero[3] = {0, 0, 0};
+            const float *nj = j < normals ? n + 3 * j : zero;
+            const int64_t cx = (int64_t)std::floor(pj[0] / cellSize), cy = (int64_t)std::floor(pj[1] / cellSize), cz = (int64_t)std::floor(pj[2] / cellSize);
+
+            uint32_t found = none;
+            for (int64_t dx = -1; dx <= 1 && found == none; dx++)
+                for (int64_t dy = -1; dy <= 1 && found == none; dy++)
+                    for (int64_t dz = -1; dz <= 1 && found == none; dz++)
+                    {
+                        std::unordered_map<uint64_t, uint32_t>::const_iterator cell = head.find(weldCell(cx + dx, cy + dy, cz + dz));
+                        if (cell == head.end())
+                            continue;
+                        for (uint32_t w = cell->second; w != none; w = next[w])
+                        {
+                            const float *pw = &position[3 * w], *nw = &normal[3 * w];
+                            const float ex = pw[0] - pj[0], ey = pw[1] - pj[1], ez = pw[2] - pj[2];
+                            if (ex * ex + ey * ey + ez * ez > tolerance2)
+                                continue;
+                            if (nw[0] * nj[0] + nw[1] * nj[1] + nw[2] * nj[2] < minCos)
+                                continue;
+                            found = w;
+                            break;
+                        }
+                    }
+
+            if (found == none)
+            {
+                found = (uint32_t)next.size();
+                const uint64_t key = weldCell(cx, cy, cz);
+                std::unordered_map<uint64_t, uint32_t>::iterator cell = head.find(key);
+                next.push_back(cell == head.end() ? none : cell->second);
+                head[key] = found;
+                position.insert(position.end(), pj, pj + 3);
+                normal.insert(normal.end(), nj, nj + 3);
+            }
+            remap[j] = found;
+        }
+    }
+}
+
+Napi::Object getWeldedBuffers(const Napi::Env env, const std::vector<std::pair<size_t, const MbGrid *>> &grids, double tolerance, double angle)
+{
+    std::vector<float> position, normal;
+    std::vector<std::vector<uint32_t>> remaps;
+    weldVertices(grids, tolerance, (float)std::cos(angle), position, normal, remaps);
+
+    // Triangles whose corners were welded together are dropped.
+    std::vector<uint32_t> index, faceIndex, groups(PACKED_GROUP_STRIDE * grids.size());
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        const MbGrid *grid = grids[g].second;
+        const uint32_t *triangles = (const uint32_t *)grid->GetTrianglesAddr();
+        const std::vector<uint32_t> &remap = remaps[g];
+        const size_t start = index.size();
+        for (size_t t = 0, tCount = grid->TrianglesCount(); t < tCount; t++)
+        {
+            const uint32_t a = remap[triangles[3 * t + 0]], b = remap[triangles[3 * t + 1]], c = remap[triangles[3 * t + 2]];
+            if (a == b || b == c || c == a)
                 continue;
-            if (!apex->IsVisible())
+            index.push_back(a);
+            index.push_back(b);
+            index.push_back(c);
+            faceIndex.push_back((uint32_t)grids[g].first);
+        }
+        uint32_t *group = &groups[PACKED_GROUP_STRIDE * g];
+        group[0] = (uint32_t)start;
+        group[1] = (uint32_t)(index.size() - start);
+        group[2] = (uint32_t)grids[g].first;
+        group[3] = (uint32_t)grid->GetStyle();
+        group[4] = (uint32_t)grid->GetPrimitiveName();
+    }
+
+    const size_t pointsCount = position.size() / 3;
+    Napi::Object result = Napi::Object::New(env);
+    if (pointsCount <= SHORT_INDEX_LIMIT)
+    {
+        Napi::Uint16Array index16 = Napi::Uint16Array::New(env, index.size());
+        std::copy(index.begin(), index.end(), index16.Data());
+        result.Set(Napi::String::New(env, "index"), index16);
+    }
+    else
+    {
+        Napi::Uint32Array index32 = Napi::Uint32Array::New(env, index.size());
+        std::copy(index.begin(), index.end(), index32.Data());
+        result.Set(Napi::String::New(env, "index"), index32);
+    }
+    Napi::Float32Array jsPosition = Napi::Float32Array::New(env, position.size());
+    std::copy(position.begin(), position.end(), jsPosition.Data());
+    Napi::Float32Array jsNormal = Napi::Float32Array::New(env, normal.size());
+    std::copy(normal.begin(), normal.end(), jsNormal.Data());
+    Napi::Uint32Array jsGroups = Napi::Uint32Array::New(env, groups.size());
+    std::copy(groups.begin(), groups.end(), jsGroups.Data());
+    Napi::Uint32Array jsFaceIndex = Napi::Uint32Array::New(env, faceIndex.size());
+    std::copy(faceIndex.begin(), faceIndex.end(), jsFaceIndex.Data());
+    result.Set(Napi::String::New(env, "position"), jsPosition);
+    result.Set(Napi::String::New(env, "normal"), jsNormal);
+    result.Set(Napi::String::New(env, "groups"), jsGroups);
+    result.Set(Napi::String::New(env, "faceIndex"), jsFaceIndex);
+    return result;
+}
+
+// The welded triangles of some grids, each with its unit normal (oriented like the grids' own normals) and centroid.
+struct WeldedTriangles
+{
+    std::vector<float> position;
+    std::vector<uint32_t> index;
+    std::vector<float> normal, centroid;
+};
+
+static void weldTriangles(const std::vector<std::pair<size_t, const MbGrid *>> &grids, double tolerance, WeldedTriangles &result)
+{
+    // Weld regardless of the normals, or every crease would become a boundary.
+    std::vector<float> vertexNormal;
+    std::vector<std::vector<uint32_t>> remaps;
+    weldVertices(grids, tolerance, -2.0f, result.position, vertexNormal, remaps);
+
+    const std::vector<float> &position = result.position;
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        const MbGrid *grid = grids[g].second;
+        const uint32_t *triangles = (const uint32_t *)grid->GetTrianglesAddr();
+        const size_t normals = std::min(grid->PointsCount(), grid->NormalsCount());
+        const float *n = (const float *)grid->GetFloatNormalsAddr();
+        const std::vector<uint32_t> &remap = remaps[g];
+        for (size_t t = 0, tCount = grid->TrianglesCount(); t < tCount; t++)
+        {
+            const uint32_t *tri = triangles + 3 * t;
+            uint32_t a = remap[tri[0]], b = remap[tri[1]], c = remap[tri[2]];
+            if (a == b || b == c || c == a)
+                continue;
+            const float *pa = &position[3 * a], *pb = &position[3 * b], *pc = &position[3 * c];
+            const float ux = pb[0] - pa[0], uy = pb[1] - pa[1], uz = pb[2] - pa[2];
+            const float vx = pc[0] - pa[0], vy = pc[1] - pa[1], vz = pc[2] - pa[2];
+            float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+            const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+            if (length == 0)
                 continue;
+            nx /= length, ny /= length, nz /= length;
+
+            // The grid's winding isn't guaranteed to match its normals, but the normals are what the renderer shows.
+            float sx = 0, sy = 0, sz = 0;
+            for (size_t i = 0; i < 3; i++)
+            {
+                if (tri[i] >= normals)
+                    continue;
+                sx += n[3 * tri[i] + 0], sy += n[3 * tri[i] + 1], sz += n[3 * tri[i] + 2];
+            }
+            if (nx * sx + ny * sy + nz * sz < 0)
+            {
+                nx = -nx, ny = -ny, nz = -nz;
+                std::swap(b, c);
+            }
+
+            result.index.push_back(a);
+            result.index.push_back(b);
+            result.index.push_back(c);
+            result.normal.push_back(nx);
+            result.normal.push_back(ny);
+            result.normal.push_back(nz);
+            result.centroid.push_back((pa[0] + pb[0] + pc[0]) / 3);
+            result.centroid.push_back((pa[1] + pb[1] + pc[1]) / 3);
+            result.centroid.push_back((pa[2] + pb[2] + pc[2]) / 3);
+        }
+    }
+}
+
+// The (at most two) triangles on each edge, keyed by its vertices (smaller one in the high bits).
+// An edge with a single triangle has second == none; one with more than two is marked with nonManifold.
+struct EdgeTriangles
+{
+    uint32_t first, second;
+    bool nonManifold;
+};
+
+static void getEdgeTriangles(const WeldedTriangles &triangles, std::unordered_map<uint64_t, EdgeTriangles> &edges)
+{
+    const uint32_t none = (uint32_t)-1;
+    const std::vector<uint32_t> &index = triangles.index;
+    edges.reserve(index.size());
+    for (uint32_t t = 0, tCount = (uint32_t)(index.size() / 3); t < tCount; t++)
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            const uint32_t a = index[3 * t + i], b = index[3 * t + (i + 1) % 3];
+            const uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+            std::unordered_map<uint64_t, EdgeTriangles>::iterator edge = edges.find(key);
+            if (edge == edges.end())
+            {
+                EdgeTriangles added = {t, none, false};
+                edges[key] = added;
+            }
+            else if (edge->second.second == none)
+                edge->second.second = t;
+            else
+                edge->second.nonManifold = true;
+        }
+    }
+}
+
+// Chains segments (pairs of welded vertices) into polylines and packs them as getPackedEdges does.
+static Napi::Object getChainedEdges(const Napi::Env env, const std::vector<float> &position, const std::vector<uint64_t> &segments)
+{
+    std::unordered_map<uint32_t, std::vector<size_t>> incident;
+    for (size_t s = 0; s < segments.size(); s++)
+    {
+        incident[(uint32_t)(segments[s] >> 32)].push_back(s);
+        incident[(uint32_t)segments[s]].push_back(s);
+    }
 
-            apex->GetPoint(p);
-            result[i] = (float)p.x;
-            result[++i] = (float)p.y;
-            result[++i] = (float)p.z;
+    std::vector<bool> used(segments.size(), false);
+    std::vector<uint32_t> points, offsets;
+    // Walks from vertex v along segment s for as long as the chain doesn't branch or end.
+    auto walk = [&](uint32_t v, size_t s)
+    {
+        offsets.push_back((uint32_t)points.size());
+        points.push_back(v);
+        for (;;)
+        {
+            used[s] = true;
+            const uint32_t a = (uint32_t)(segments[s] >> 32), b = (uint32_t)segments[s];
+            v = v == a ? b : a;
+            points.push_back(v);
+            const std::vector<size_t> &around = incident[v];
+            if (around.size() != 2)
+                break;
+            s = around[0] == s ? around[1] : around[0];
+            if (used[s])
+                break;
         }
+    };
+    // Open chains start at an end or a branch; what remains are closed loops.
+    for (std::unordered_map<uint32_t, std::vector<size_t>>::const_iterator it = incident.begin(); it != incident.end(); ++it)
+    {
+        if (it->second.size() == 2)
+            continue;
+        for (size_t i = 0; i < it->second.size(); i++)
+            if (!used[it->second[i]])
+                walk(it->first, it->second[i]);
+    }
+    for (size_t s = 0; s < segments.size(); s++)
+        if (!used[s])
+            walk((uint32_t)(segments[s] >> 32), s);
+    offsets.push_back((uint32_t)points.size());
+
+    const size_t pointsCount = points.size();
+    const size_t offsetsOffset = sizeof(float) * 3 * pointsCount;
+    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, offsetsOffset + sizeof(uint32_t) * offsets.size());
+    uint8_t *data = (uint8_t *)buf.Data();
+    float *jsPosition = (float *)data;
+    for (size_t j = 0; j < pointsCount; j++)
+    {
+        const float *p = &position[3 * points[j]];
+        jsPosition[3 * j + 0] = p[0];
+        jsPosition[3 * j + 1] = p[1];
+        jsPosition[3 * j + 2] = p[2];
     }
+    std::copy(offsets.begin(), offsets.end(), (uint32_t *)(data + offsetsOffset));
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "position"), Napi::Float32Array::New(env, 3 * pointsCount, buf, 0));
+    result.Set(Napi::String::New(env, "offsets"), Napi::Uint32Array::New(env, offsets.size(), buf, offsetsOffset));
     return result;
 }
 
+Napi::Object getFeatureEdges(const Napi::Env env, const std::vector<std::pair<size_t, const MbGrid *>> &grids, double tolerance, double angle)
+{
+    WeldedTriangles triangles;
+    weldTriangles(grids, tolerance, triangles);
+    std::unordered_map<uint64_t, EdgeTriangles> edges;
+    getEdgeTriangles(triangles, edges);
+
+    const uint32_t none = (uint32_t)-1;
+    const float minCos = (float)std::cos(angle);
+    const std::vector<float> &normal = triangles.normal;
+    std::vector<uint64_t> segments;
+    for (std::unordered_map<uint64_t, EdgeTriangles>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+    {
+        const EdgeTriangles &edge = it->second;
+        if (edge.second != none && !edge.nonManifold)
+        {
+            const float *n1 = &normal[3 * edge.first], *n2 = &normal[3 * edge.second];
+            if (n1[0] * n2[0] + n1[1] * n2[1] + n1[2] * n2[2] >= minCos)
+                continue;
+        }
+        segments.push_back(it->first);
+    }
+    return getChainedEdges(env, triangles.position, segments);
+}
+
+static void getVisibleGrids(const MbMesh *mesh, std::vector<std::pair<size_t, const MbGrid *>> &grids)
+{
+    for (size_t i = 0, iCount = mesh->GridsCount(); i < iCount; i++)
+    {
+        const MbGrid *grid = mesh->GetGrid(i);
+        if (grid == NULL || !grid->IsVisible())
+            continue;
+        grids.push_back(std::make_pair(i, grid));
+    }
+}
+
+Napi::Value Mesh::GetWeldedBuffers_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value Mesh::GetWeldedBuffers(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    {
+        Napi::Error::New(env, "double tolerance and double angle are required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<std::pair<size_t, const MbGrid *>> grids;
+    getVisibleGrids(_underlying, grids);
+    return getWeldedBuffers(env, grids, info[0].ToNumber().DoubleValue(), info[1].ToNumber().DoubleValue());
+}
+
+Napi::Value Mesh::GetFeatureEdges_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value Mesh::GetFeatureEdges(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    {
+        Napi::Error::New(env, "double tolerance and double angle are required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<std::pair<size_t, const MbGrid *>> grids;
+    getVisibleGrids(_underlying, grids);
+    return getFeatureEdges(env, grids, info[0].ToNumber().DoubleValue(), info[1].ToNumber().DoubleValue());
+}
+
+SilhouetteEdges::SilhouetteEdges(const Napi::CallbackInfo &info) : Napi::ObjectWrap<SilhouetteEdges>(info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !(info[0].IsObject() && info[0].ToObject().InstanceOf(Mesh::GetConstructor(env))) || !info[1].IsNumber())
+    {
+        Napi::Error::New(env, "Mesh mesh and double tolerance are required.").ThrowAsJavaScriptException();
+        return;
+    }
+    std::vector<std::pair<size_t, const MbGrid *>> grids;
+    getVisibleGrids(Mesh::Unwrap(info[0].ToObject())->_underlying, grids);
+    WeldedTriangles triangles;
+    weldTriangles(grids, info[1].ToNumber().DoubleValue(), triangles);
+    std::unordered_map<uint64_t, EdgeTriangles> adjacency;
+    getEdgeTriangles(triangles, adjacency);
+
+    // Only edges between exactly two triangles can be silhouettes
+    const uint32_t none = (uint32_t)-1;
+    for (std::unordered_map<uint64_t, EdgeTriangles>::const_iterator it = adjacency.begin(); it != adjacency.end(); ++it)
+    {
+        const EdgeTriangles &edge = it->second;
+        if (edge.second == none || edge.nonManifold)
+            continue;
+        edges.push_back(it->first);
+        edgeTriangles.push_back(edge.first);
+        edgeTriangles.push_back(edge.second);
+    }
+    position.swap(triangles.position);
+    normal.swap(triangles.normal);
+    centroid.swap(triangles.centroid);
+}
+
+Napi::Object SilhouetteEdges::Init(const Napi::Env env, Napi::Object exports)
+{
+    Napi::Function func = DefineClass(env, "SilhouetteEdges", {
+                                                                  InstanceMethod<&SilhouetteEdges::Get>("Get"),
+                                                              });
+    exports.Set("SilhouetteEdges", func);
+    return exports;
+}
+
+Napi::Value SilhouetteEdges::Get(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsObject())
+    {
+        Napi::Error::New(env, "ViewCamera camera is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const Napi::Object camera = info[0].As<Napi::Object>();
+    MbCartPoint3D eye;
+    MbVector3D direction;
+    double fov;
+    if (!getTriple(env, camera, "camera", "eye", eye.x, eye.y, eye.z) ||
+        !getTriple(env, camera, "camera", "direction", direction.x, direction.y, direction.z) ||
+        !getNumber(env, camera, "camera", "fov", fov))
+        return env.Undefined();
+
+    const size_t count = normal.size() / 3;
+    std::vector<bool> front(count);
+    for (size_t t = 0; t < count; t++)
+    {
+        const float *n = &normal[3 * t], *c = &centroid[3 * t];
+        const double vx = fov > 0 ? c[0] - eye.x : direction.x;
+        const double vy = fov > 0 ? c[1] - eye.y : direction.y;
+        const double vz = fov > 0 ? c[2] - eye.z : direction.z;
+        front[t] = n[0] * vx + n[1] * vy + n[2] * vz < 0;
+    }
+
+    std::vector<uint64_t> segments;
+    for (size_t e = 0; e < edges.size(); e++)
+        if (front[edgeTriangles[2 * e]] != front[edgeTriangles[2 * e + 1]])
+            segments.push_back(edges[e]);
+    return getChainedEdges(env, position, segments);
+}
+
+Napi::Value Mesh::GetApexes_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value Mesh::GetApexes(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    MbMesh *mesh = _underlying;
+    std::vector<const MbApex3D *> apexes;
+    for (size_t k = 0, count = mesh->ApexesCount(); k < count; k++)
+    {
+        const MbApex3D *apex = mesh->GetApex(k);
+        if (apex == NULL)
+            continue;
+        if (!apex->IsVisible())
+            continue;
+        apexes.push_back(apex);
+    }
+
+    const size_t count = apexes.size();
+    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, sizeof(float) * 3 * count);
+    float *data = (float *)buf.Data();
+    MbCartPoint3D p;
+    for (size_t k = 0; k < count; k++)
+    {
+        apexes[k]->GetPoint(p);
+        data[3 * k + 0] = (float)p.x;
+        data[3 * k + 1] = (float)p.y;
+        data[3 * k + 2] = (float)p.z;
+    }
+    return Napi::Float32Array::New(env, 3 * count, buf, 0);
+}
+
+bool isDisplayedPolygon(const MbPolygon3D *polygon, bool outlinesOnly)
+{
+    if (outlinesOnly)
+    {
+        const MbTopItem *item = polygon->TopItem();
+        if (item == NULL)
+            return false;
+
+        if (item->IsA() != tt_CurveEdge)
+            return false;
+
+        if (!polygon->IsVisible())
+            return false;
+
+        const MbCurveEdge *edge = (const MbCurveEdge *)item;
+
+        if (edge->IsPole())
+            return false;
+        if (edge->IsSeam())
+            return false;
+    }
+    else
+    {
+        if (!polygon->IsVisible())
+            return false;
+    }
+    return true;
+}
+
+bool getEdgeBuffer(const Napi::Env env, const MbPolygon3D *polygon, bool outlinesOnly, Napi::Object &jsInfo)
+{
+    if (!isDisplayedPolygon(polygon, outlinesOnly))
+        return false;
+
+    if (outlinesOnly)
+    {
+        const MbCurveEdge *edge = (const MbCurveEdge *)polygon->TopItem();
+        jsInfo.Set(Napi::String::New(env, "simpleName"), Napi::Number::New(env, edge->GetNameHash()));
+    }
+
+    MbCartPoint3D p;
+    size_t pointsCnt = polygon->Count();
+    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, 4 * 3 * pointsCnt);
+    Napi::Float32Array line = Napi::Float32Array::New(env, 3 * pointsCnt, buf, 0);
+    size_t i = 0;
+    // FIXME: benchmark and see if removing the copy would help
+    for (size_t n = 0; n < pointsCnt; n++)
+    {
+        polygon->GetPoint(n, p);
+        line[i++] = (float)p.x;
+        line[i++] = (float)p.y;
+        line[i++] = (float)p.z;
+    }
+    jsInfo.Set(Napi::String::New(env, "position"), line);
+    return true;
+}
+
 Napi::Value Mesh::GetEdges_async(const Napi::CallbackInfo &info)
 {
     return info.Env().Undefined();
@@ -137,62 +916,120 @@ Napi::Value Mesh::GetEdges(const Napi::CallbackInfo &info)
     Napi::Array result = Napi::Array::New(env);
     if (count > 0)
     {
-        MbCartPoint3D p;
-        size_t j = 0, edgeIndex = 0;
+        size_t j = 0;
         for (size_t k = 0; k < count; k++)
         {
-            Napi::Object jsInfo = Napi::Object::New(env);
-
             const MbPolygon3D *polygon = mesh->GetPolygon(k);
             if (polygon == NULL)
                 continue;
 
-            if (outlinesOnly)
-            {
-                const MbTopItem *item = polygon->TopItem();
-                if (item == NULL)
-                    continue;
+            Napi::Object jsInfo = Napi::Object::New(env);
+            if (getEdgeBuffer(env, polygon, outlinesOnly, jsInfo))
+                result[j++] = jsInfo;
+        }
+    }
+    return result;
+}
 
-                if (item->IsA() != tt_CurveEdge)
-                    continue;
+Napi::Object getPackedEdges(const Napi::Env env, const std::vector<const MbPolygon3D *> &polygons, const std::vector<SimpleName> &names)
+{
+    const size_t count = polygons.size();
+    size_t pointsCount = 0;
+    for (size_t k = 0; k < count; k++)
+        pointsCount += polygons[k]->Count();
 
-                edgeIndex++;
+    // Everything lives in a single ArrayBuffer: [position | offsets | simpleNames]
+    const size_t offsetsOffset = sizeof(float) * 3 * pointsCount;
+    const size_t namesOffset = offsetsOffset + sizeof(uint32_t) * (count + 1);
+    Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, namesOffset + sizeof(uint32_t) * count);
+    uint8_t *data = (uint8_t *)buf.Data();
+    float *position = (float *)data;
+    uint32_t *offsets = (uint32_t *)(data + offsetsOffset);
+    uint32_t *simpleNames = (uint32_t *)(data + namesOffset);
 
-                if (!polygon->IsVisible())
-                    continue;
+    MbCartPoint3D p;
+    size_t offset = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        const MbPolygon3D *polygon = polygons[k];
+        offsets[k] = (uint32_t)offset;
+        simpleNames[k] = (uint32_t)names[k];
+        for (size_t n = 0, pointsCnt = polygon->Count(); n < pointsCnt; n++, offset++)
+        {
+            polygon->GetPoint(n, p);
+            position[3 * offset + 0] = (float)p.x;
+            position[3 * offset + 1] = (float)p.y;
+            position[3 * offset + 2] = (float)p.z;
+        }
+    }
+    offsets[count] = (uint32_t)offset;
 
-                MbCurveEdge *edge = (MbCurveEdge *)item;
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "position"), Napi::Float32Array::New(env, 3 * pointsCount, buf, 0));
+    result.Set(Napi::String::New(env, "offsets"), Napi::Uint32Array::New(env, count + 1, buf, offsetsOffset));
+    result.Set(Napi::String::New(env, "simpleNames"), Napi::Uint32Array::New(env, count, buf, namesOffset));
+    return result;
+}
 
-                if (edge->IsPole())
-                    continue;
-                if (edge->IsSeam())
-                    continue;
+Napi::Value Mesh::GetPackedEdges_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
 
-                jsInfo.Set(Napi::String::New(env, "simpleName"), Napi::Number::New(env, edge->GetNameHash()));
-            }
-            else
-            {
-                if (!polygon->IsVisible())
-                    continue;
-            }
+Napi::Value Mesh::GetPackedEdges(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    bool outlinesOnly = false;
+    if (info.Length() == 1 && info[0].IsBoolean())
+        outlinesOnly = info[0].ToBoolean();
 
-            size_t pointsCnt = polygon->Count();
-            Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(env, 4 * 3 * pointsCnt);
-            Napi::Float32Array line = Napi::Float32Array::New(env, 3 * pointsCnt, buf, 0);
-            size_t i = 0;
-            // FIXME: benchmark and see if removing the copy would help
-            for (size_t n = 0; n < pointsCnt; n++)
-            {
-                polygon->GetPoint(n, p);
-                line[i++] = (float)p.x;
-                line[i++] = (float)p.y;
-                line[i++] = (float)p.z;
-            }
-            jsInfo.Set(Napi::String::New(env, "position"), line);
-            result[j++] = jsInfo;
-        }
+    MbMesh *mesh = _underlying;
+    std::vector<const MbPolygon3D *> polygons;
+    std::vector<SimpleName> names;
+    for (size_t k = 0, count = mesh->PolygonsCount(); k < count; k++)
+    {
+        const MbPolygon3D *polygon = mesh->GetPolygon(k);
+        if (polygon == NULL)
+            continue;
+        if (!isDisplayedPolygon(polygon, outlinesOnly))
+            continue;
+
+        polygons.push_back(polygon);
+        names.push_back(outlinesOnly ? ((const MbCurveEdge *)polygon->TopItem())->GetNameHash() : polygon->GetPrimitiveName());
     }
-    return result;
+    return getPackedEdges(env, polygons, names);
+}
+
+bool getNumber(const Napi::Env env, const Napi::Object object, const char *name, const char *key, double &result)
+{
+    Napi::Value value = object.Get(key);
+    if (!value.IsNumber())
+    {
+        Napi::Error::New(env, std::string("number ") + name + "." + key + " is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    result = value.ToNumber().DoubleValue();
+    return true;
+}
+
+bool getTriple(const Napi::Env env, const Napi::Object object, const char *name, const char *key, double &x, double &y, double &z)
+{
+    Napi::Value value = object.Get(key);
+    if (!value.IsArray() || value.As<Napi::Array>().Length() != 3)
+    {
+        Napi::Error::New(env, std::string("number[] ") + name + "." + key + " of length 3 is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Array array = value.As<Napi::Array>();
+    if (!array.Get((uint32_t)0).IsNumber() || !array.Get(1).IsNumber() || !array.Get(2).IsNumber())
+    {
+        Napi::Error::New(env, std::string("number[] ") + name + "." + key + " of length 3 is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    x = array.Get((uint32_t)0).ToNumber().DoubleValue();
+    y = array.Get(1).ToNumber().DoubleValue();
+    z = array.Get(2).ToNumber().DoubleValue();
+    return true;
 }
 
 void AutoReg(MbAutoRegDuplicate *&autoReg, MbRegDuplicate *&iReg)
@@ -0,0 +1,553 @@
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+
+#include "../include/MeshBVH.h"
+#include "../include/Grid.h"
+
+// Triangles per leaf
+#define BVH_LEAF_SIZE 4
+// Deep enough for any tree built by median splits of 2^32 triangles
+#define BVH_STACK_SIZE 64
+
+MeshBVH::MeshBVH(const Napi::CallbackInfo &info) : Napi::ObjectWrap<MeshBVH>(info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || info.Length() > 2 || !info[0].IsArray())
+    {
+        Napi::Error::New(env, "Grid[] grids is required.").ThrowAsJavaScriptException();
+        return;
+    }
+    const Napi::Array grids_ = info[0].As<Napi::Array>();
+    std::vector<const MbGrid *> grids;
+    for (uint32_t i = 0; i < grids_.Length(); i++)
+    {
+        const Napi::Value grid = grids_[i];
+        if (!(grid.IsObject() && grid.ToObject().InstanceOf(Grid::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "Grid[] grids is required.").ThrowAsJavaScriptException();
+            return;
+        }
+        grids.push_back(Grid::Unwrap(grid.ToObject())->_underlying);
+    }
+
+    edgeFirst.push_back(0);
+    if (info.Length() == 2 && !info[1].IsUndefined())
+    {
+        if (!info[1].IsArray())
+        {
+            Napi::Error::New(env, "Float32Array[] edges is required.").ThrowAsJavaScriptException();
+            return;
+        }
+        const Napi::Array edges = info[1].As<Napi::Array>();
+        for (uint32_t e = 0; e < edges.Length(); e++)
+        {
+            const Napi::Value edge = edges[e];
+            if (!edge.IsTypedArray() || edge.As<Napi::TypedArray>().TypedArrayType() != napi_float32_array)
+            {
+                Napi::Error::New(env, "Float32Array[] edges is required.").ThrowAsJavaScriptException();
+                return;
+            }
+            const Napi::Float32Array polyline = edge.As<Napi::Float32Array>();
+            const size_t count = polyline.ElementLength() / 6;
+            const float *p = polyline.Data();
+            float bounds[6] = {HUGE_VALF, HUGE_VALF, HUGE_VALF, -HUGE_VALF, -HUGE_VALF, -HUGE_VALF};
+            for (size_t j = 0; j < 6 * count; j++)
+            {
+                bounds[j % 3] = std::min(bounds[j % 3], p[j]);
+                bounds[3 + j % 3] = std::max(bounds[3 + j % 3], p[j]);
+            }
+            segments.insert(segments.end(), p, p + 6 * count);
+            edgeFirst.push_back((uint32_t)(segments.size() / 6));
+            edgeBounds.insert(edgeBounds.end(), bounds, bounds + 6);
+        }
+    }
+    Build(grids);
+}
+
+Napi::Object MeshBVH::Init(const Napi::Env env, Napi::Object exports)
+{
+    Napi::Function func = DefineClass(env, "MeshBVH", {
+                                                          InstanceMethod<&MeshBVH::Raycast>("Raycast"),
+                                                          InstanceMethod<&MeshBVH::Boxcast>("Boxcast"),
+                                                          InstanceAccessor<&MeshBVH::GetValue_triangleCount>("triangleCount"),
+                                                      });
+    exports.Set("MeshBVH", func);
+    return exports;
+}
+
+Napi::Function MeshBVH::GetConstructor(Napi::Env env)
+{
+    Napi::Object obj = env.GetInstanceData<Napi::ObjectReference>()->Value();
+    Napi::Value value = obj.Get("MeshBVH");
+    Napi::Function f = value.As<Napi::Function>();
+    return f;
+}
+
+void MeshBVH::Build(const std::vector<const MbGrid *> &grids)
+{
+    faceCount = grids.size();
+    std::vector<float> unordered;
+    std::vector<int32_t> faces;
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        const MbGrid *grid = grids[g];
+        if (grid == NULL)
+            continue;
+        const float *p = (const float *)grid->GetFloatPointsAddr();
+        const uint32_t *t = (const uint32_t *)grid->GetTrianglesAddr();
+        for (size_t j = 0, jCount = grid->TrianglesCount(); j < jCount; j++)
+        {
+            for (size_t i = 0; i < 3; i++)
+                unordered.insert(unordered.end(), p + 3 * t[3 * j + i], p + 3 * t[3 * j + i] + 3);
+            faces.push_back((int32_t)g);
+        }
+    }
+
+    const uint32_t count = (uint32_t)faces.size();
+    centroids.resize(3 * count);
+    order.resize(count);
+    for (uint32_t j = 0; j < count; j++)
+    {
+        const float *v = &unordered[9 * j];
+        for (size_t i = 0; i < 3; i++)
+            centroids[3 * j + i] = (v[i] + v[3 + i] + v[6 + i]) / 3;
+        order[j] = j;
+    }
+
+    nodes.reserve(count > 0 ? 2 * (count / BVH_LEAF_SIZE + 1) : 0);
+    if (count > 0)
+        Split(0, count);
+
+    // The triangles are stored in leaf order, so that a leaf reads one contiguous run
+    triangles.resize(9 * count);
+    triangleFaces.resize(count);
+    for (uint32_t j = 0; j < count; j++)
+    {
+        memcpy(&triangles[9 * j], &unordered[9 * order[j]], sizeof(float) * 9);
+        triangleFaces[j] = faces[order[j]];
+    }
+    std::vector<float>().swap(centroids);
+    std::vector<uint32_t>().swap(order);
+
+    // Children always come after their parent, so going backwards bounds them first
+    for (size_t n = nodes.size(); n-- > 0;)
+    {
+        Node &node = nodes[n];
+        if (node.right == 0)
+        {
+            Bound(node);
+            continue;
+        }
+        const Node &l = nodes[n + 1], &r = nodes[node.right];
+        for (size_t i = 0; i < 3; i++)
+        {
+            node.min[i] = std::min(l.min[i], r.min[i]);
+            node.max[i] = std::max(l.max[i], r.max[i]);
+        }
+    }
+}
+
+// Median split on the longest axis of the centroids' bounds; the nodes are bounded once the tree is built.
+// Returns the index of the node made.
+uint32_t MeshBVH::Split(uint32_t first, uint32_t count)
+{
+    const uint32_t index = (uint32_t)nodes.size();
+    nodes.push_back(Node());
+    nodes[index].first = first;
+    nodes[index].count = count;
+
+    float cmin[3] = {HUGE_VALF, HUGE_VALF, HUGE_VALF}, cmax[3] = {-HUGE_VALF, -HUGE_VALF, -HUGE_VALF};
+    for (uint32_t j = first; j < first + count; j++)
+        for (size_t i = 0; i < 3; i++)
+        {
+            cmin[i] = std::min(cmin[i], centroids[3 * order[j] + i]);
+            cmax[i] = std::max(cmax[i], centroids[3 * order[j] + i]);
+        }
+    size_t axis = 0;
+    for (size_t i = 1; i < 3; i++)
+        if (cmax[i] - cmin[i] > cmax[axis] - cmin[axis])
+            axis = i;
+
+    if (count <= BVH_LEAF_SIZE || cmax[axis] <= cmin[axis])
+    {
+        nodes[index].right = 0;
+        return index;
+    }
+
+    const uint32_t half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [this, axis](uint32_t a, uint32_t b)
+                     { return centroids[3 * a + axis] < centroids[3 * b + axis]; });
+
+    Split(first, half);
+    const uint32_t right = Split(first + half, count - half);
+    nodes[index].right = right;
+    return index;
+}
+
+void MeshBVH::Bound(Node &node) const
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        node.min[i] = HUGE_VALF;
+        node.max[i] = -HUGE_VALF;
+    }
+    for (uint32_t j = node.first; j < node.first + node.count; j++)
+        for (size_t v = 0; v < 3; v++)
+            for (size_t i = 0; i < 3; i++)
+            {
+                node.min[i] = std::min(node.min[i], triangles[9 * j + 3 * v + i]);
+                node.max[i] = std::max(node.max[i], triangles[9 * j + 3 * v + i]);
+            }
+}
+
+// Slab test; the entry distance, or infinity on a miss
+static inline float intersectBox(const float min[3], const float max[3], const float origin[3], const float inverse[3], float far)
+{
+    float tmin = 0, tmax = far;
+    for (size_t i = 0; i < 3; i++)
+    {
+        float t0 = (min[i] - origin[i]) * inverse[i];
+        float t1 = (max[i] - origin[i]) * inverse[i];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        // NaN (a zero direction component with the origin on a slab boundary) doesn't narrow the interval
+        if (t0 > tmin)
+            tmin = t0;
+        if (t1 < tmax)
+            tmax = t1;
+        if (tmin > tmax)
+            return HUGE_VALF;
+    }
+    return tmin;
+}
+
+// Möller–Trumbore, from either side
+static inline bool intersectTriangle(const float *v, const float origin[3], const float direction[3], float &t)
+{
+    const float e1[3] = {v[3] - v[0], v[4] - v[1], v[5] - v[2]};
+    const float e2[3] = {v[6] - v[0], v[7] - v[1], v[8] - v[2]};
+    const float p[3] = {direction[1] * e2[2] - direction[2] * e2[1], direction[2] * e2[0] - direction[0] * e2[2], direction[0] * e2[1] - direction[1] * e2[0]};
+    const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (std::fabs(det) < 1e-12f)
+        return false;
+    const float inv = 1 / det;
+    const float s[3] = {origin[0] - v[0], origin[1] - v[1], origin[2] - v[2]};
+    const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+    if (u < 0 || u > 1)
+        return false;
+    const float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+    const float w = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inv;
+    if (w < 0 || u + w > 1)
+        return false;
+    t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+    return t >= 0;
+}
+
+int MeshBVH::Intersect(const float origin[3], const float direction[3], float &t, float near, float far) const
+{
+    if (nodes.empty())
+        return -1;
+    const float inverse[3] = {1 / direction[0], 1 / direction[1], 1 / direction[2]};
+    // Starting from far prunes the boxes beyond it as any hit would
+    float best = far;
+    int hit = -1;
+
+    uint32_t stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    if (intersectBox(nodes[0].min, nodes[0].max, origin, inverse, best) == HUGE_VALF)
+        return -1;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node &node = nodes[stack[--top]];
+        if (node.right == 0)
+        {
+            for (uint32_t j = node.first; j < node.first + node.count; j++)
+            {
+                float tj;
+                if (intersectTriangle(&triangles[9 * j], origin, direction, tj) && tj >= near && tj < best)
+                {
+                    best = tj;
+                    hit = triangleFaces[j];
+                }
+            }
+            continue;
+        }
+
+        // Nearer child first, so that its hits prune the farther one
+        const uint32_t left = (uint32_t)(&node - &nodes[0]) + 1, right = node.right;
+        const float tl = intersectBox(nodes[left].min, nodes[left].max, origin, inverse, best);
+        const float tr = intersectBox(nodes[right].min, nodes[right].max, origin, inverse, best);
+        if (tl <= tr)
+        {
+            if (tr != HUGE_VALF)
+                stack[top++] = right;
+            if (tl != HUGE_VALF)
+                stack[top++] = left;
+        }
+        else
+        {
+            if (tl != HUGE_VALF)
+                stack[top++] = left;
+            stack[top++] = right;
+        }
+    }
+    if (hit >= 0)
+        t = best;
+    return hit;
+}
+
+Napi::Value MeshBVH::Raycast(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || info.Length() > 3 || !info[0].IsTypedArray() || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array)
+    {
+        Napi::Error::New(env, "Float32Array rays is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    float near = 0, far = HUGE_VALF;
+    if (info.Length() > 1 && !info[1].IsUndefined())
+    {
+        if (!info[1].IsNumber())
+        {
+            Napi::Error::New(env, "number near is required.").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        near = info[1].ToNumber().FloatValue();
+    }
+    if (info.Length() > 2 && !info[2].IsUndefined())
+    {
+        if (!info[2].IsNumber())
+        {
+            Napi::Error::New(env, "number far is required.").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        far = info[2].ToNumber().FloatValue();
+    }
+    const Napi::Float32Array rays = info[0].As<Napi::Float32Array>();
+    const size_t count = rays.ElementLength() / 6;
+
+    Napi::Int32Array faces = Napi::Int32Array::New(env, count);
+    Napi::Float32Array t = Napi::Float32Array::New(env, count);
+    Napi::Float32Array point = Napi::Float32Array::New(env, 3 * count);
+    const float *r = rays.Data();
+    for (size_t k = 0; k < count; k++)
+    {
+        const float *origin = r + 6 * k, *direction = r + 6 * k + 3;
+        float tk = 0;
+        faces[k] = Intersect(origin, direction, tk, near, far);
+        t[k] = faces[k] >= 0 ? tk : HUGE_VALF;
+        for (size_t i = 0; i < 3; i++)
+            point[3 * k + i] = faces[k] >= 0 ? origin[i] + tk * direction[i] : 0;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "faces"), faces);
+    result.Set(Napi::String::New(env, "t"), t);
+    result.Set(Napi::String::New(env, "point"), point);
+    return result;
+}
+
+#define FRUSTUM_PLANES 6
+
+enum
+{
+    OUTSIDE,
+    INTERSECTS,
+    INSIDE
+};
+
+// Positive inside, as with THREE.Plane.distanceToPoint
+static inline float distanceToPoint(const float *plane, const float *p)
+{
+    return plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3];
+}
+
+static inline bool containsPoint(const float *planes, const float *p)
+{
+    for (size_t k = 0; k < FRUSTUM_PLANES; k++)
+        if (distanceToPoint(planes + 4 * k, p) < 0)
+            return false;
+    return true;
+}
+
+// Conservative: a box outside no single plane but outside the frustum as a whole counts as intersecting
+static inline int classifyBox(const float *planes, const float min[3], const float max[3])
+{
+    int result = INSIDE;
+    for (size_t k = 0; k < FRUSTUM_PLANES; k++)
+    {
+        const float *plane = planes + 4 * k;
+        // The corners farthest along and against the normal
+        float far[3], near[3];
+        for (size_t i = 0; i < 3; i++)
+        {
+            far[i] = plane[i] >= 0 ? max[i] : min[i];
+            near[i] = plane[i] >= 0 ? min[i] : max[i];
+        }
+        if (distanceToPoint(plane, far) < 0)
+            return OUTSIDE;
+        if (distanceToPoint(plane, near) < 0)
+            result = INTERSECTS;
+    }
+    return result;
+}
+
+// Clips the segment by each plane in turn; whatever is left is inside
+static inline bool intersectsSegment(const float *planes, const float *a, const float *b)
+{
+    float t0 = 0, t1 = 1;
+    for (size_t k = 0; k < FRUSTUM_PLANES; k++)
+    {
+        const float da = distanceToPoint(planes + 4 * k, a), db = distanceToPoint(planes + 4 * k, b);
+        if (da < 0 && db < 0)
+            return false;
+        if (da >= 0 && db >= 0)
+            continue;
+        const float t = da / (da - db);
+        if (da < 0)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+#define FACE_TOUCHED 1
+#define FACE_ESCAPED 2
+
+// A face is touched when any of its triangles is in the frustum and escapes when any of its vertices is outside.
+// Subtrees entirely inside or outside decide their triangles without testing them.
+void MeshBVH::SelectFaces(const float *planes, bool contained, std::vector<int32_t> &result) const
+{
+    if (nodes.empty())
+        return;
+    std::vector<uint8_t> state(faceCount, 0);
+
+    uint32_t stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node &node = nodes[stack[--top]];
+        const int classification = classifyBox(planes, node.min, node.max);
+        if (classification == OUTSIDE)
+        {
+            if (contained)
+                for (uint32_t j = node.first; j < node.first + node.count; j++)
+                    state[triangleFaces[j]] |= FACE_ESCAPED;
+            continue;
+        }
+        if (classification == INSIDE)
+        {
+            for (uint32_t j = node.first; j < node.first + node.count; j++)
+                state[triangleFaces[j]] |= FACE_TOUCHED;
+            continue;
+        }
+        if (node.right != 0)
+        {
+            stack[top++] = node.right;
+            stack[top++] = (uint32_t)(&node - &nodes[0]) + 1;
+            continue;
+        }
+
+        for (uint32_t j = node.first; j < node.first + node.count; j++)
+        {
+            uint8_t &s = state[triangleFaces[j]];
+            // Already decided
+            if (contained ? (s & FACE_ESCAPED) : (s & FACE_TOUCHED))
+                continue;
+            const float *v = &triangles[9 * j];
+            const bool a = containsPoint(planes, v), b = containsPoint(planes, v + 3), c = containsPoint(planes, v + 6);
+            if (a && b && c)
+            {
+                s |= FACE_TOUCHED;
+                continue;
+            }
+            s |= FACE_ESCAPED;
+            if (!contained && (a || b || c || intersectsSegment(planes, v, v + 3) || intersectsSegment(planes, v, v + 6) || intersectsSegment(planes, v + 3, v + 6)))
+                s |= FACE_TOUCHED;
+        }
+    }
+
+    for (size_t f = 0; f < faceCount; f++)
+    {
+        const bool selected = contained ? state[f] == FACE_TOUCHED : (state[f] & FACE_TOUCHED) != 0;
+        if (selected)
+            result.push_back((int32_t)f);
+    }
+}
+
+void MeshBVH::SelectEdges(const float *planes, bool contained, std::vector<int32_t> &result) const
+{
+    for (size_t e = 0, count = edgeFirst.size() - 1; e < count; e++)
+    {
+        const float *bounds = &edgeBounds[6 * e];
+        const int classification = classifyBox(planes, bounds, bounds + 3);
+        if (classification == OUTSIDE)
+            continue;
+        bool selected = classification == INSIDE;
+        if (!selected)
+        {
+            selected = contained;
+            for (uint32_t j = edgeFirst[e]; j < edgeFirst[e + 1]; j++)
+            {
+                const float *s = &segments[6 * j];
+                if (contained && !(containsPoint(planes, s) && containsPoint(planes, s + 3)))
+                {
+                    selected = false;
+                    break;
+                }
+                if (!contained && intersectsSegment(planes, s, s + 3))
+                {
+                    selected = true;
+                    break;
+                }
+            }
+        }
+        if (selected)
+            result.push_back((int32_t)e);
+    }
+}
+
+Napi::Value MeshBVH::Boxcast(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsTypedArray() || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array || info[0].As<Napi::Float32Array>().ElementLength() != 4 * FRUSTUM_PLANES)
+    {
+        Napi::Error::New(env, "Float32Array planes is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 2 || !info[1].IsBoolean())
+    {
+        Napi::Error::New(env, "boolean contained is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const float *planes = info[0].As<Napi::Float32Array>().Data();
+    const bool contained = info[1].As<Napi::Boolean>().Value();
+
+    std::vector<int32_t> faces, edges;
+    SelectFaces(planes, contained, faces);
+    SelectEdges(planes, contained, edges);
+
+    Napi::Int32Array faces_ = Napi::Int32Array::New(env, faces.size());
+    if (!faces.empty())
+        memcpy(faces_.Data(), faces.data(), sizeof(int32_t) * faces.size());
+    Napi::Int32Array edges_ = Napi::Int32Array::New(env, edges.size());
+    if (!edges.empty())
+        memcpy(edges_.Data(), edges.data(), sizeof(int32_t) * edges.size());
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "faces"), faces_);
+    result.Set(Napi::String::New(env, "edges"), edges_);
+    return result;
+}
+
+Napi::Value MeshBVH::GetValue_triangleCount(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), (double)triangleFaces.size());
+}
@@ -0,0 +1,527 @@
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+#include "../include/MeshExportAddon.h"
+#include "../include/MeshExport.h"
+#include "../include/Mesh.h"
+
+// Progress is reported (and cancellation checked) after about this many triangles
+#define PROGRESS_STEP 65536
+// Output is buffered in chunks of about this many bytes
+#define WRITE_BUFFER (1 << 20)
+
+MeshFileWriter::MeshFileWriter(Format format, const std::vector<const MbMesh *> &meshes, const c3d::path_string &fileName, double scale, const Napi::Value indicator_)
+    : format(format), meshes(meshes), fileName(fileName), scale((float)scale), indicator(NULL), written(0), reported(0)
+{
+    for (size_t m = 0; m < meshes.size(); m++)
+        meshes[m]->AddRef();
+    if (indicator_.IsObject())
+    {
+        indicatorObject = Napi::Persistent(indicator_.ToObject());
+        indicator = ProgressIndicator::Unwrap(indicator_.ToObject());
+    }
+}
+
+MeshFileWriter::~MeshFileWriter()
+{
+    for (size_t m = 0; m < meshes.size(); m++)
+        meshes[m]->Release();
+}
+
+// The grids of mesh m that have triangles to write
+static void getWrittenGrids(const MbMesh *mesh, std::vector<const MbGrid *> &grids)
+{
+    for (size_t i = 0, iCount = mesh->GridsCount(); i < iCount; i++)
+    {
+        const MbGrid *grid = mesh->GetGrid(i);
+        if (grid == NULL || !grid->IsVisible() || grid->TrianglesCount() == 0)
+            continue;
+        grids.push_back(grid);
+    }
+}
+
+static inline bool hasNormals(const MbGrid *grid)
+{
+    return grid->NormalsCount() >= grid->PointsCount();
+}
+
+bool MeshFileWriter::Progress(size_t triangles)
+{
+    written += triangles;
+    if (indicator == NULL || written - reported < PROGRESS_STEP)
+        return true;
+    const size_t n = written - reported;
+    reported = written;
+    return indicator->Progress(n);
+}
+
+bool MeshFileWriter::Calculate()
+{
+    std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        if (indicator != NULL)
+            indicator->ReleaseProgress();
+        return false;
+    }
+
+    bool success;
+    try
+    {
+        switch (format)
+        {
+        case STL:
+            success = WriteStl(out);
+            break;
+        case OBJ:
+            success = WriteObj(out);
+            break;
+        default:
+            success = WriteGlb(out);
+            break;
+        }
+    }
+    catch (...)
+    {
+        success = false;
+    }
+    out.close();
+    success = success && !out.fail();
+
+    if (indicator != NULL)
+    {
+        if (success)
+        {
+            if (written > reported)
+                indicator->Progress(written - reported);
+            indicator->Success();
+        }
+        // Otherwise the indicator, its callback and everything they refer to would never be collected
+        indicator->ReleaseProgress();
+    }
+    return success;
+}
+
+Napi::Value MeshFileWriter::ToJs(const Napi::Env env)
+{
+    return Napi::Number::New(env, (double)written);
+}
+
+bool MeshFileWriter::WriteStl(std::ofstream &out)
+{
+    std::vector<const MbGrid *> grids;
+    for (size_t m = 0; m < meshes.size(); m++)
+        getWrittenGrids(meshes[m], grids);
+    uint32_t count = 0;
+    for (size_t g = 0; g < grids.size(); g++)
+        count += (uint32_t)grids[g]->TrianglesCount();
+
+    char header[80];
+    memset(header, 0, sizeof(header));
+    strncpy(header, "binary STL", sizeof(header));
+    out.write(header, sizeof(header));
+    out.write((const char *)&count, sizeof(count));
+
+    // Each triangle is a normal, 3 corners and a 2 byte attribute
+    const size_t recordSize = 12 * sizeof(float) + sizeof(uint16_t);
+    std::vector<char> buffer;
+    buffer.reserve(WRITE_BUFFER);
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        const MbGrid *grid = grids[g];
+        const float *p = (const float *)grid->GetFloatPointsAddr();
+        const uint32_t *triangles = (const uint32_t *)grid->GetTrianglesAddr();
+        for (size_t t = 0, tCount = grid->TrianglesCount(); t < tCount; t++)
+        {
+            float record[12];
+            for (size_t i = 0; i < 3; i++)
+            {
+                const float *pi = p + 3 * triangles[3 * t + i];
+                record[3 + 3 * i + 0] = scale * pi[0];
+                record[3 + 3 * i + 1] = scale * pi[1];
+                record[3 + 3 * i + 2] = scale * pi[2];
+            }
+            const float *a = record + 3, *b = record + 6, *c = record + 9;
+            const float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+            const float vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+            float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+            const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+            if (length > 0)
+                nx /= length, ny /= length, nz /= length;
+            record[0] = nx, record[1] = ny, record[2] = nz;
+
+            const size_t at = buffer.size();
+            buffer.resize(at + recordSize, 0);
+            memcpy(&buffer[at], record, sizeof(record));
+            if (buffer.size() + recordSize > WRITE_BUFFER)
+            {
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        if (!out || !Progress(grid->TrianglesCount()))
+            return false;
+    }
+    out.write(buffer.data(), buffer.size());
+    return true;
+}
+
+bool MeshFileWriter::WriteObj(std::ofstream &out)
+{
+    std::string buffer;
+    buffer.reserve(WRITE_BUFFER);
+    char line[128];
+    size_t base = 1; // OBJ indices start at 1 and count through the whole file
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        std::vector<const MbGrid *> grids;
+        getWrittenGrids(meshes[m], grids);
+        if (grids.empty())
+            continue;
+        snprintf(line, sizeof(line), "o mesh%zu\n", m);
+        buffer += line;
+        for (size_t g = 0; g < grids.size(); g++)
+        {
+            const MbGrid *grid = grids[g];
+            const size_t points = grid->PointsCount();
+            const bool normals = hasNormals(grid);
+            const float *p = (const float *)grid->GetFloatPointsAddr();
+            const float *n = (const float *)grid->GetFloatNormalsAddr();
+            for (size_t j = 0; j < points; j++)
+            {
+                snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", scale * p[3 * j + 0], scale * p[3 * j + 1], scale * p[3 * j + 2]);
+                buffer += line;
+            }
+            if (normals)
+            {
+                for (size_t j = 0; j < points; j++)
+                {
+                    snprintf(line, sizeof(line), "vn %.6g %.6g %.6g\n", n[3 * j + 0], n[3 * j + 1], n[3 * j + 2]);
+                    buffer += line;
+                }
+            }
+            const uint32_t *triangles = (const uint32_t *)grid->GetTrianglesAddr();
+            for (size_t t = 0, tCount = grid->TrianglesCount(); t < tCount; t++)
+            {
+                const size_t a = base + triangles[3 * t + 0], b = base + triangles[3 * t + 1], c = base + triangles[3 * t + 2];
+                if (normals)
+                    snprintf(line, sizeof(line), "f %zu//%zu %zu//%zu %zu//%zu\n", a, a, b, b, c, c);
+                else
+                    snprintf(line, sizeof(line), "f %zu %zu %zu\n", a, b, c);
+                buffer += line;
+                if (buffer.size() > WRITE_BUFFER)
+                {
+                    out.write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+            base += points;
+            if (!out || !Progress(grid->TrianglesCount()))
+                return false;
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    return true;
+}
+
+static inline void writeUint32(std::ofstream &out, uint32_t value)
+{
+    out.write((const char *)&value, sizeof(value));
+}
+
+static void writeAccessor(std::ostringstream &json, size_t bufferView, size_t componentType, size_t count, const char *type)
+{
+    json << "{\"bufferView\":" << bufferView << ",\"componentType\":" << componentType << ",\"count\":" << count << ",\"type\":\"" << type << "\"";
+}
+
+// A single-buffer binary glTF: one node and mesh per MbMesh and one primitive per grid, each with its own
+// position, normal and index buffer views. The JSON is laid out up front, so the buffer can be streamed.
+bool MeshFileWriter::WriteGlb(std::ofstream &out)
+{
+    std::vector<std::vector<const MbGrid *>> meshGrids(meshes.size());
+    for (size_t m = 0; m < meshes.size(); m++)
+        getWrittenGrids(meshes[m], meshGrids[m]);
+
+    std::ostringstream meshesJson, accessorsJson, viewsJson, nodesJson;
+    meshesJson.precision(9);
+    accessorsJson.precision(9);
+    size_t meshCount = 0, accessorCount = 0, viewCount = 0, byteLength = 0;
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        const std::vector<const MbGrid *> &grids = meshGrids[m];
+        if (grids.empty())
+            continue;
+        nodesJson << (meshCount > 0 ? "," : "") << "{\"mesh\":" << meshCount << "}";
+        meshesJson << (meshCount > 0 ? "," : "") << "{\"primitives\":[";
+        meshCount++;
+        for (size_t g = 0; g < grids.size(); g++)
+        {
+            const MbGrid *grid = grids[g];
+            const size_t points = grid->PointsCount();
+            const size_t indices = 3 * grid->TrianglesCount();
+            const bool normals = hasNormals(grid);
+
+            // POSITION requires its bounds
+            float min[3] = {HUGE_VALF, HUGE_VALF, HUGE_VALF}, max[3] = {-HUGE_VALF, -HUGE_VALF, -HUGE_VALF};
+            const float *p = (const float *)grid->GetFloatPointsAddr();
+            for (size_t j = 0; j < points; j++)
+                for (size_t i = 0; i < 3; i++)
+                {
+                    min[i] = std::min(min[i], scale * p[3 * j + i]);
+                    max[i] = std::max(max[i], scale * p[3 * j + i]);
+                }
+
+            meshesJson << (g > 0 ? "," : "") << "{\"attributes\":{\"POSITION\":" << accessorCount;
+            if (accessorCount > 0)
+                accessorsJson << ",";
+            writeAccessor(accessorsJson, viewCount, 5126, points, "VEC3");
+            accessorsJson << ",\"min\":[" << min[0] << "," << min[1] << "," << min[2] << "],\"max\":[" << max[0] << "," << max[1] << "," << max[2] << "]}";
+            if (viewCount > 0)
+                viewsJson << ",";
+            viewsJson << "{\"buffer\":0,\"byteOffset\":" << byteLength << ",\"byteLength\":" << 12 * points << ",\"target\":34962}";
+            byteLength += 12 * points;
+            accessorCount++, viewCount++;
+
+            if (normals)
+            {
+                meshesJson << ",\"NORMAL\":" << accessorCount;
+                accessorsJson << ",";
+                writeAccessor(accessorsJson, viewCount, 5126, points, "VEC3");
+                accessorsJson << "}";
+                viewsJson << ",{\"buffer\":0,\"byteOffset\":" << byteLength << ",\"byteLength\":" << 12 * points << ",\"target\":34962}";
+                byteLength += 12 * points;
+                accessorCount++, viewCount++;
+            }
+
+            meshesJson << "},\"indices\":" << accessorCount << ",\"mode\":4}";
+            accessorsJson << ",";
+            writeAccessor(accessorsJson, viewCount, 5125, indices, "SCALAR");
+            accessorsJson << "}";
+            viewsJson << ",{\"buffer\":0,\"byteOffset\":" << byteLength << ",\"byteLength\":" << 4 * indices << ",\"target\":34963}";
+            byteLength += 4 * indices;
+            accessorCount++, viewCount++;
+        }
+        meshesJson << "]}";
+    }
+
+    std::ostringstream json;
+    json << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for (size_t m = 0; m < meshCount; m++)
+        json << (m > 0 ? "," : "") << m;
+    json << "]}],\"nodes\":[" << nodesJson.str() << "],\"meshes\":[" << meshesJson.str() << "],\"accessors\":[" << accessorsJson.str()
+         << "],\"bufferViews\":[" << viewsJson.str() << "],\"buffers\":[{\"byteLength\":" << byteLength << "}]}";
+    std::string header = json.str();
+    // Chunks are 4 byte aligned; JSON is padded with spaces. All of the binary data is 4 byte sized already.
+    while (header.size() % 4 != 0)
+        header += ' ';
+
+    writeUint32(out, 0x46546C67); // glTF
+    writeUint32(out, 2);
+    writeUint32(out, (uint32_t)(12 + 8 + header.size() + 8 + byteLength));
+    writeUint32(out, (uint32_t)header.size());
+    writeUint32(out, 0x4E4F534A); // JSON
+    out.write(header.data(), header.size());
+    writeUint32(out, (uint32_t)byteLength);
+    writeUint32(out, 0x004E4942); // BIN
+
+    std::vector<float> scaled;
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        const std::vector<const MbGrid *> &grids = meshGrids[m];
+        for (size_t g = 0; g < grids.size(); g++)
+        {
+            const MbGrid *grid = grids[g];
+            const size_t points = grid->PointsCount();
+            const float *p = (const float *)grid->GetFloatPointsAddr();
+            scaled.resize(3 * points);
+            for (size_t j = 0; j < 3 * points; j++)
+                scaled[j] = scale * p[j];
+            out.write((const char *)scaled.data(), sizeof(float) * 3 * points);
+            if (hasNormals(grid))
+                out.write((const char *)grid->GetFloatNormalsAddr(), sizeof(float) * 3 * points);
+            out.write((const char *)grid->GetTrianglesAddr(), sizeof(uint32_t) * 3 * grid->TrianglesCount());
+            if (!out || !Progress(grid->TrianglesCount()))
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename Writer>
+class WriteMesh_AsyncWorker : public PromiseWorker
+{
+public:
+    WriteMesh_AsyncWorker(Napi::Promise::Deferred const &d, Writer *writer, const char *name)
+        : PromiseWorker(d), writer(writer), name(name) {}
+    virtual ~WriteMesh_AsyncWorker() { delete writer; }
+
+    void Execute() override
+    {
+        if (!writer->Calculate())
+            SetError(std::string("Operation ") + name + " failed");
+    }
+
+    void Resolve(Napi::Promise::Deferred const &deferred) override
+    {
+        deferred.Resolve(writer->ToJs(deferred.Env()));
+    }
+
+    void Reject(Napi::Promise::Deferred const &deferred, Napi::Error const &error) override
+    {
+        error.Value()["isC3dError"] = true;
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Writer *writer;
+    const char *name;
+};
+
+static bool getMeshes(const Napi::Env env, const Napi::Value value, std::vector<const MbMesh *> &result)
+{
+    if (!value.IsArray())
+    {
+        Napi::Error::New(env, "Mesh[] meshes is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    const Napi::Array meshes = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < meshes.Length(); i++)
+    {
+        const Napi::Value mesh = meshes[i];
+        if (!(mesh.IsObject() && mesh.ToObject().InstanceOf(Mesh::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "Mesh[] meshes is required.").ThrowAsJavaScriptException();
+            return false;
+        }
+        result.push_back(Mesh::Unwrap(mesh.ToObject())->_underlying);
+    }
+    return true;
+}
+
+static MeshFileWriter *newMeshFileWriter(MeshFileWriter::Format format, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3 && info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 3 or 4 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<const MbMesh *> meshes;
+    if (!getMeshes(env, info[0], meshes))
+        return NULL;
+    if (!info[1].IsString())
+    {
+        Napi::Error::New(env, "string fileName is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[2].IsNumber())
+    {
+        Napi::Error::New(env, "double scale is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    Napi::Value indicator = env.Undefined();
+    if (info.Length() == 4 && !(info[3].IsNull() || info[3].IsUndefined()))
+    {
+        if (!(info[3].IsObject() && info[3].ToObject().InstanceOf(ProgressIndicator::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "ProgressIndicator indicator must be a ProgressIndicator.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        indicator = info[3];
+    }
+    const c3d::path_string fileName = c3d::StdToPathstring(info[1].ToString());
+    return new MeshFileWriter(format, meshes, fileName, info[2].ToNumber().DoubleValue(), indicator);
+}
+
+static Napi::Value writeMeshFile(MeshFileWriter::Format format, const char *name, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    MeshFileWriter *writer = newMeshFileWriter(format, info);
+    if (writer == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (writer->Calculate())
+        result = writer->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, std::string("Operation ") + name + " failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete writer;
+    return result;
+}
+
+static Napi::Value writeMeshFileAsync(MeshFileWriter::Format format, const char *name, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    MeshFileWriter *writer = newMeshFileWriter(format, info);
+    if (writer == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    WriteMesh_AsyncWorker<MeshFileWriter> *asyncWorker = new WriteMesh_AsyncWorker<MeshFileWriter>(deferred, writer, name);
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+Napi::Value MeshExport::WriteStl(const Napi::CallbackInfo &info)
+{
+    return writeMeshFile(MeshFileWriter::STL, "WriteStl", info);
+}
+
+Napi::Value MeshExport::WriteStl_async(const Napi::CallbackInfo &info)
+{
+    return writeMeshFileAsync(MeshFileWriter::STL, "WriteStl", info);
+}
+
+Napi::Value MeshExport::WriteObj(const Napi::CallbackInfo &info)
+{
+    return writeMeshFile(MeshFileWriter::OBJ, "WriteObj", info);
+}
+
+Napi::Value MeshExport::WriteObj_async(const Napi::CallbackInfo &info)
+{
+    return writeMeshFileAsync(MeshFileWriter::OBJ, "WriteObj", info);
+}
+
+Napi::Value MeshExport::WriteGlb(const Napi::CallbackInfo &info)
+{
+    return writeMeshFile(MeshFileWriter::GLB, "WriteGlb", info);
+}
+
+Napi::Value MeshExport::WriteGlb_async(const Napi::CallbackInfo &info)
+{
+    return writeMeshFileAsync(MeshFileWriter::GLB, "WriteGlb", info);
+}
+
+Napi::Value MeshExport::CountTriangles(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 1)
+    {
+        Napi::Error::New(env, "Expecting 1 parameter").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<const MbMesh *> meshes;
+    if (!getMeshes(env, info[0], meshes))
+        return env.Undefined();
+    size_t count = 0;
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        std::vector<const MbGrid *> grids;
+        getWrittenGrids(meshes[m], grids);
+        for (size_t g = 0; g < grids.size(); g++)
+            count += grids[g]->TrianglesCount();
+    }
+    return Napi::Number::New(env, (double)count);
+}
+
+Napi::Value MeshExport::CountTriangles_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
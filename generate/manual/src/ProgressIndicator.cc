@@ -1,7 +1,7 @@
 
 #include "../include/ProgressIndicator.h"
 
-ProgressIndicator::ProgressIndicator(const Napi::CallbackInfo &info) : Napi::ObjectWrap<ProgressIndicator>(info)
+ProgressIndicator::ProgressIndicator(const Napi::CallbackInfo &info) : Napi::ObjectWrap<ProgressIndicator>(info), cancel(false)
 {
 }
 
@@ -9,7 +9,7 @@ ProgressIndicator::~ProgressIndicator()
 {
     onSuccess.Release();
     onCancel.Release();
-    onProgress.Release();
+    ReleaseProgress();
 }
 
 Napi::Object ProgressIndicator::Init(const Napi::Env env, Napi::Object exports)
@@ -25,6 +25,14 @@ Napi::Object ProgressIndicator::Init(const Napi::Env env, Napi::Object exports)
     return exports;
 }
 
+Napi::Function ProgressIndicator::GetConstructor(Napi::Env env)
+{
+    Napi::Object obj = env.GetInstanceData<Napi::ObjectReference>()->Value();
+    Napi::Value value = obj.Get("ProgressIndicator");
+    Napi::Function f = value.As<Napi::Function>();
+    return f;
+}
+
 bool ProgressIndicator::Initialize(size_t, size_t, IStrData &strData)
 {
     cancel = false;
@@ -33,6 +41,9 @@ bool ProgressIndicator::Initialize(size_t, size_t, IStrData &strData)
 
 bool ProgressIndicator::Progress(size_t n)
 {
+    // No progress callback has been set
+    if (static_cast<napi_threadsafe_function>(onProgress) == nullptr)
+        return !IsCancel();
     size_t *value = new size_t(n);
     onProgress.BlockingCall(value);
     return !IsCancel();
@@ -42,6 +53,15 @@ void ProgressIndicator::Success()
 {
 }
 
+void ProgressIndicator::ReleaseProgress()
+{
+    if (static_cast<napi_threadsafe_function>(onProgress) == nullptr)
+        return;
+    // The TSFN's context holds a strong reference to this object; releasing the TSFN deletes it
+    onProgress.Release();
+    onProgress = PROGRESS();
+}
+
 void ProgressIndicator::Stop()
 {
 }
@@ -93,6 +113,7 @@ void ProgressIndicator::SetValue_progress(const Napi::CallbackInfo &info, const
         throw Napi::TypeError::New(env, "Expected first arg to be function");
     }
 
+    ReleaseProgress();
     Context *context = new Napi::Reference<Napi::Value>(Persistent(info.This()));
 
     onProgress = PROGRESS::New(env, info[0].As<Napi::Function>(), "Progress", 0, 1, context,
@@ -0,0 +1,210 @@
+#include <string.h>
+#include <algorithm>
+
+#include "../include/SolidIntersectionAddon.h"
+#include "../include/SolidIntersection.h"
+#include "../include/Solid.h"
+#include "../include/SNameMaker.h"
+#include "../include/PromiseWorker.h"
+#include "../include/TessellationAddon.h"
+
+#include "action.h"
+#include "tool_mutex.h"
+
+SolidIntersector::SolidIntersector(const std::vector<const MbSolid *> &solids, const std::vector<const MbSolid *> &candidates, const MbSNameMaker &names)
+    : solids(solids), candidates(candidates), names(names)
+{
+    for (size_t i = 0; i < solids.size(); i++)
+        solids[i]->AddRef();
+    for (size_t i = 0; i < candidates.size(); i++)
+        candidates[i]->AddRef();
+}
+
+SolidIntersector::~SolidIntersector()
+{
+    for (size_t i = 0; i < solids.size(); i++)
+        solids[i]->Release();
+    for (size_t i = 0; i < candidates.size(); i++)
+        candidates[i]->Release();
+}
+
+bool SolidIntersector::Calculate()
+{
+    intersecting.assign(candidates.size(), 0);
+
+    // With the solids sorted by their lower x, a candidate need only be checked against those beginning before it ends
+    std::vector<MbCube> cubes(solids.size());
+    std::vector<size_t> sorted(solids.size());
+    for (size_t s = 0; s < solids.size(); s++)
+    {
+        solids[s]->AddYourGabaritTo(cubes[s]);
+        sorted[s] = s;
+    }
+    std::sort(sorted.begin(), sorted.end(), [&cubes](size_t a, size_t b)
+              { return cubes[a].pmin.x < cubes[b].pmin.x; });
+
+    std::vector<std::vector<size_t>> overlapping(candidates.size());
+    std::vector<size_t> order;
+    std::vector<size_t> sizes(candidates.size(), 0);
+    for (size_t c = 0; c < candidates.size(); c++)
+    {
+        MbCube cube;
+        candidates[c]->AddYourGabaritTo(cube);
+        if (cube.IsEmpty())
+            continue;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const MbCube &other = cubes[sorted[i]];
+            if (other.pmin.x > cube.pmax.x)
+                break;
+            if (!other.IsEmpty() && cube.Intersect(other))
+                overlapping[c].push_back(sorted[i]);
+        }
+        if (overlapping[c].empty())
+            continue;
+        order.push_back(c);
+        sizes[c] = candidates[c]->GetFacesCount();
+    }
+    // Candidates with the most faces first, so that the slowest checks don't start last
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b)
+                     { return sizes[a] > sizes[b]; });
+
+    std::atomic<bool> failed(false);
+    EnterParallelRegion();
+    ParallelFor(order, [&](size_t c)
+                {
+                    try
+                    {
+                        for (size_t i = 0; i < overlapping[c].size(); i++)
+                        {
+                            // Each thread names with its own copy
+                            MbSNameMaker copy(names);
+                            if (::IsSolidsIntersection(*solids[overlapping[c][i]], *candidates[c], copy))
+                            {
+                                intersecting[c] = 1;
+                                break;
+                            }
+                        }
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                    }
+                });
+    ExitParallelRegion();
+    return !failed;
+}
+
+Napi::Value SolidIntersector::ToJs(const Napi::Env env)
+{
+    Napi::Uint8Array result = Napi::Uint8Array::New(env, intersecting.size());
+    if (!intersecting.empty())
+        memcpy(result.Data(), intersecting.data(), intersecting.size());
+    return result;
+}
+
+class SolidIntersection_AsyncWorker : public PromiseWorker
+{
+public:
+    SolidIntersection_AsyncWorker(Napi::Promise::Deferred const &d, SolidIntersector *intersector)
+        : PromiseWorker(d), intersector(intersector) {}
+    virtual ~SolidIntersection_AsyncWorker() { delete intersector; }
+
+    void Execute() override
+    {
+        if (!intersector->Calculate())
+            SetError("Operation Intersect failed");
+    }
+
+    void Resolve(Napi::Promise::Deferred const &deferred) override
+    {
+        deferred.Resolve(intersector->ToJs(deferred.Env()));
+    }
+
+    void Reject(Napi::Promise::Deferred const &deferred, Napi::Error const &error) override
+    {
+        error.Value()["isC3dError"] = true;
+        deferred.Reject(error.Value());
+    }
+
+private:
+    SolidIntersector *intersector;
+};
+
+static bool getSolids(const Napi::Env env, const Napi::Value value, const char *message, std::vector<const MbSolid *> &result)
+{
+    if (!value.IsArray())
+    {
+        Napi::Error::New(env, message).ThrowAsJavaScriptException();
+        return false;
+    }
+    const Napi::Array solids = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < solids.Length(); i++)
+    {
+        const Napi::Value solid = solids[i];
+        if (!(solid.IsObject() && solid.ToObject().InstanceOf(Solid::GetConstructor(env))))
+        {
+            Napi::Error::New(env, message).ThrowAsJavaScriptException();
+            return false;
+        }
+        result.push_back(Solid::Unwrap(solid.ToObject())->_underlying);
+    }
+    return true;
+}
+
+static SolidIntersector *newSolidIntersector(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3)
+    {
+        Napi::Error::New(env, "Expecting 3 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<const MbSolid *> solids, candidates;
+    if (!getSolids(env, info[0], "Solid[] solids is required.", solids))
+        return NULL;
+    if (!getSolids(env, info[1], "Solid[] candidates is required.", candidates))
+        return NULL;
+    if (!(info[2].IsObject() && info[2].ToObject().InstanceOf(SNameMaker::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "SNameMaker names is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbSNameMaker *names = SNameMaker::Unwrap(info[2].ToObject())->_underlying;
+    return new SolidIntersector(solids, candidates, *names);
+}
+
+Napi::Value SolidIntersection::Intersect(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    SolidIntersector *intersector = newSolidIntersector(info);
+    if (intersector == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (intersector->Calculate())
+        result = intersector->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Intersect failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete intersector;
+    return result;
+}
+
+Napi::Value SolidIntersection::Intersect_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    SolidIntersector *intersector = newSolidIntersector(info);
+    if (intersector == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    SolidIntersection_AsyncWorker *asyncWorker = new SolidIntersection_AsyncWorker(deferred, intersector);
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
@@ -0,0 +1,2334 @@
+#include <algorithm>
+
+#include "../include/TessellationAddon.h"
+#include "../include/MeshAddon.h"
+#include "../include/Solid.h"
+#include "../include/StepData.h"
+#include "../include/FormNote.h"
+#include "../include/CurveEdge.h"
+#include "../include/TessellationCache.h"
+#include "../include/MeshBufferPool.h"
+#include "../include/Grid.h"
+#include "../include/ViewTessellation.h"
+#include "../include/RegionTessellation.h"
+#include "../include/CurveTessellation.h"
+#include "../include/SpaceInstance.h"
+#include "../include/Region.h"
+#include "../include/Placement3D.h"
+#include "../include/_SolidDuplicate.h"
+#include "../include/_DuplicationValues.h"
+#include "../include/ModelAddon.h"
+
+#include "tool_mutex.h"
+#include "tri_face.h"
+
+// Roughly what the viewport keeps around for a medium sized model
+#define DEFAULT_GRID_CACHE_BUDGET (256 * 1024 * 1024)
+// Enough for the faces of a few large temporary solids
+#define GRID_POOL_LIMIT 4096
+// "GRID", the first word of a buffer written by GridChunkWriter
+#define GRID_CHUNK_MAGIC 0x44495247
+#define GRID_CHUNK_VERSION 2
+
+static inline void hashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    // FNV-1a
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+static inline void hashDouble(uint64_t &hash, double d)
+{
+    d += 0.0; // -0.0 and 0.0 hash the same
+    hashBytes(hash, &d, sizeof(d));
+}
+
+static inline void hashPoint(uint64_t &hash, const MbCartPoint3D &p)
+{
+    hashDouble(hash, p.x);
+    hashDouble(hash, p.y);
+    hashDouble(hash, p.z);
+}
+
+// Grid chunks are little-endian whatever the host, so a saved file reads the same on any machine.
+static inline void putUint32(char *&at, uint32_t value)
+{
+    for (size_t b = 0; b < sizeof(value); b++)
+        *at++ = (char)(value >> (8 * b));
+}
+
+static inline void putUint64(char *&at, uint64_t value)
+{
+    for (size_t b = 0; b < sizeof(value); b++)
+        *at++ = (char)(value >> (8 * b));
+}
+
+static inline void putFloat(char *&at, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putUint32(at, bits);
+}
+
+static inline uint32_t getUint32(const char *&at)
+{
+    uint32_t value = 0;
+    for (size_t b = 0; b < sizeof(value); b++)
+        value |= (uint32_t)(uint8_t)*at++ << (8 * b);
+    return value;
+}
+
+static inline uint64_t getUint64(const char *&at)
+{
+    uint64_t value = 0;
+    for (size_t b = 0; b < sizeof(value); b++)
+        value |= (uint64_t)(uint8_t)*at++ << (8 * b);
+    return value;
+}
+
+static inline float getFloat(const char *&at)
+{
+    const uint32_t bits = getUint32(at);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+GridCache::GridCache() : budget(DEFAULT_GRID_CACHE_BUDGET), bytes(0), hits(0), misses(0), evictions(0) {}
+
+GridCache &GridCache::Instance()
+{
+    static GridCache instance;
+    return instance;
+}
+
+// The surface as a file would write it: its whole content, whatever its type.
+static void hashSurface(uint64_t &hash, const MbSurface &surface)
+{
+    membuf memBuf;
+    writer::writer_ptr wrt = writer::CreateMemWriter(memBuf, 0);
+    *wrt << &surface;
+    memBuf.closeBuff();
+
+    const size_t size = (size_t)memBuf.getMemLen();
+    const char *memory = NULL;
+    memBuf.toMemory(memory);
+    hashBytes(hash, memory, size);
+    delete[] memory;
+}
+
+// NOTE: Face objects are copied by almost every operation, so pointers and ids are useless here.
+// Instead the key is the name, orientation, the content of the surface, the bounding box, loop vertices
+// and an interior point. The surface settles what is meshed and the rest where it is trimmed, so two
+// faces only share a key if they are the same up to the shape of edges between the same vertices.
+uint64_t GridCache::Key(const MbFace &face, const MbStepData &stepData, const MbFormNote &formNote)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    const SimpleName name = face.GetNameHash();
+    hashBytes(hash, &name, sizeof(name));
+    const bool sense = face.IsSameSense();
+    hashBytes(hash, &sense, sizeof(sense));
+    hashSurface(hash, face.GetSurface());
+
+    MbCube cube;
+    face.AddYourGabaritTo(cube);
+    hashPoint(hash, cube.pmin);
+    hashPoint(hash, cube.pmax);
+
+    MbCartPoint3D p;
+    for (size_t i = 0, iCount = face.GetLoopsCount(); i < iCount; i++)
+    {
+        const MbLoop *loop = face.GetLoop(i);
+        for (size_t j = 0, jCount = (size_t)loop->GetEdgesCount(); j < jCount; j++)
+        {
+            loop->GetOrientedEdge(j)->GetBegVertex().GetCartPoint(p);
+            hashPoint(hash, p);
+        }
+    }
+    MbVector3D normal;
+    if (face.GetAnyPointOn(p, normal))
+        hashPoint(hash, p);
+
+    const MbeStepType stepType = stepData.GetStepType();
+    hashBytes(hash, &stepType, sizeof(stepType));
+    hashDouble(hash, stepData.GetSag());
+    hashDouble(hash, stepData.GetAngle());
+    hashDouble(hash, stepData.GetLength());
+    const bool flags[] = {formNote.Wire(), formNote.Grid(), formNote.Seam(), formNote.Quad(), formNote.Fair()};
+    hashBytes(hash, flags, sizeof(flags));
+
+    return hash;
+}
+
+static size_t gridBytes(const MbGrid &grid)
+{
+    return sizeof(MbGrid) + sizeof(MbFloatPoint3D) * (grid.PointsCount() + grid.NormalsCount()) + sizeof(MbTriangle) * grid.TrianglesCount();
+}
+
+MbGrid *GridCache::Get(uint64_t key)
+{
+    const MbGrid *grid = NULL;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<uint64_t, Entry>::iterator found = entries.find(key);
+        if (found == entries.end())
+        {
+            misses++;
+            return NULL;
+        }
+        hits++;
+        lru.splice(lru.begin(), lru, found->second.lru);
+        grid = found->second.grid;
+        grid->AddRef();
+    }
+    MbGrid *result = static_cast<MbGrid *>(&grid->Duplicate());
+    grid->Release();
+    return result;
+}
+
+MbGrid *GridCache::Find(uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint64_t, Entry>::iterator found = entries.find(key);
+    if (found == entries.end())
+        return NULL;
+    found->second.grid->AddRef();
+    return found->second.grid;
+}
+
+void GridCache::Put(uint64_t key, const MbGrid &grid)
+{
+    const size_t size = gridBytes(grid);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (size > budget)
+            return;
+    }
+
+    // The copy must not keep the face (and so the whole old solid) alive.
+    MbGrid *copy = static_cast<MbGrid *>(&grid.Duplicate());
+    copy->SetItem(NULL);
+    copy->AddRef();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint64_t, Entry>::iterator found = entries.find(key);
+    if (found != entries.end())
+    {
+        copy->Release();
+        lru.splice(lru.begin(), lru, found->second.lru);
+        return;
+    }
+    lru.push_front(key);
+    Entry entry = {copy, size, lru.begin()};
+    entries[key] = entry;
+    bytes += size;
+    Evict();
+}
+
+// Assumes the mutex is held.
+void GridCache::Evict()
+{
+    while (bytes > budget && !lru.empty())
+    {
+        std::unordered_map<uint64_t, Entry>::iterator found = entries.find(lru.back());
+        bytes -= found->second.bytes;
+        found->second.grid->Release();
+        entries.erase(found);
+        lru.pop_back();
+        evictions++;
+    }
+}
+
+void GridCache::SetBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    Evict();
+}
+
+void GridCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::unordered_map<uint64_t, Entry>::iterator i = entries.begin(); i != entries.end(); ++i)
+        i->second.grid->Release();
+    entries.clear();
+    for (size_t s = 0; s < stashed.size(); s++)
+        for (size_t g = 0; g < stashed[s].grids.size(); g++)
+            stashed[s].grids[g].second->Release();
+    stashed.clear();
+    lru.clear();
+    bytes = hits = misses = evictions = 0;
+}
+
+GridCache::Stats GridCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats = {hits, misses, evictions, entries.size(), bytes, budget};
+    return stats;
+}
+
+uint64_t GridCache::ItemHash(const MbSolid &solid)
+{
+    // Written just as a saved file would write it
+    MbModel *model = new MbModel();
+    model->AddRef();
+    model->AddItem(const_cast<MbSolid &>(solid));
+    const char *memory = NULL;
+    const size_t size = WriteItems(*model, memory);
+    model->Release();
+
+    uint64_t hash = 14695981039346656037ULL;
+    hashBytes(hash, memory, size);
+    delete[] memory;
+    return hash;
+}
+
+void GridCache::Stash(uint64_t item, size_t faceCount, std::vector<std::pair<uint64_t, MbGrid *>> &grids)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Stashed entry = {item, faceCount, std::vector<std::pair<uint64_t, MbGrid *>>()};
+    entry.grids.swap(grids);
+    stashed.push_back(entry);
+}
+
+void GridCache::Claim(const MbSolid &solid)
+{
+    const size_t faceCount = solid.GetFacesCount();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool candidate = false;
+        for (size_t s = 0; s < stashed.size() && !candidate; s++)
+            candidate = stashed[s].faceCount == faceCount;
+        if (!candidate)
+            return;
+    }
+
+    const uint64_t item = ItemHash(solid);
+    std::vector<std::pair<uint64_t, MbGrid *>> grids;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t s = 0; s < stashed.size(); s++)
+            if (stashed[s].item == item)
+            {
+                grids.swap(stashed[s].grids);
+                stashed.erase(stashed.begin() + s);
+                break;
+            }
+    }
+    for (size_t g = 0; g < grids.size(); g++)
+    {
+        Put(grids[g].first, *grids[g].second);
+        grids[g].second->Release();
+    }
+}
+
+Napi::Value TessellationCache::SetBudget_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value TessellationCache::SetBudget(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber() || info[0].ToNumber().Int64Value() < 0)
+    {
+        Napi::Error::New(env, "size_t bytes is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    GridCache::Instance().SetBudget((size_t)info[0].ToNumber().Int64Value());
+    return env.Undefined();
+}
+
+Napi::Value TessellationCache::Clear_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value TessellationCache::Clear(const Napi::CallbackInfo &info)
+{
+    GridCache::Instance().Clear();
+    return info.Env().Undefined();
+}
+
+Napi::Value TessellationCache::GetStats_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value TessellationCache::GetStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    const GridCache::Stats stats = GridCache::Instance().GetStats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "hits"), Napi::Number::New(env, stats.hits));
+    result.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, stats.misses));
+    result.Set(Napi::String::New(env, "evictions"), Napi::Number::New(env, stats.evictions));
+    result.Set(Napi::String::New(env, "entries"), Napi::Number::New(env, stats.entries));
+    result.Set(Napi::String::New(env, "bytes"), Napi::Number::New(env, stats.bytes));
+    result.Set(Napi::String::New(env, "budget"), Napi::Number::New(env, stats.budget));
+    return result;
+}
+
+GridPool &GridPool::Instance()
+{
+    static GridPool instance;
+    return instance;
+}
+
+void GridPool::Put(MbGrid &grid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (grids.size() >= GRID_POOL_LIMIT || std::find(grids.begin(), grids.end(), &grid) != grids.end())
+        return;
+    // As in the cache, a pooled grid must not keep its face (and so the whole old solid) alive.
+    grid.SetItem(NULL);
+    grid.AddRef();
+    grids.push_back(&grid);
+}
+
+MbGrid *GridPool::Take()
+{
+    MbGrid *grid = NULL;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t g = grids.size(); g-- > 0;)
+        {
+            if (grids[g]->GetUseCount() != 1)
+                continue;
+            grid = grids[g];
+            grids[g] = grids.back();
+            grids.pop_back();
+            break;
+        }
+    }
+    if (grid != NULL)
+        grid->Flush();
+    return grid;
+}
+
+void GridPool::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t g = 0; g < grids.size(); g++)
+        grids[g]->Release();
+    grids.clear();
+}
+
+size_t GridPool::Count()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return grids.size();
+}
+
+Napi::Value MeshBufferPool::Recycle_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value MeshBufferPool::Recycle(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsArray())
+    {
+        Napi::Error::New(env, "MeshBuffer[] buffers is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    GridPool &pool = GridPool::Instance();
+    Napi::Array buffers = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < buffers.Length(); i++)
+    {
+        Napi::Value buffer = buffers[i];
+        if (!buffer.IsObject())
+            continue;
+        Napi::Value grid = buffer.ToObject().Get("grid");
+        if (grid.IsObject() && grid.ToObject().InstanceOf(Grid::GetConstructor(env)))
+            pool.Put(*Grid::Unwrap(grid.ToObject())->_underlying);
+    }
+    return env.Undefined();
+}
+
+Napi::Value MeshBufferPool::Pack_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+// As Mesh.GetPackedBuffers, for the grids of buffers from any number of meshes; each group's i is its buffer's.
+Napi::Value MeshBufferPool::Pack(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsArray())
+    {
+        Napi::Error::New(env, "MeshBuffer[] buffers is required.").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<std::pair<size_t, const MbGrid *>> grids;
+    Napi::Array buffers = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < buffers.Length(); i++)
+    {
+        Napi::Value buffer = buffers[i];
+        Napi::Value grid = buffer.IsObject() ? buffer.ToObject().Get("grid") : env.Undefined();
+        if (!(grid.IsObject() && grid.ToObject().InstanceOf(Grid::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "MeshBuffer[] buffers is required.").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        grids.push_back(std::make_pair((size_t)buffer.ToObject().Get("i").ToNumber().Int64Value(), Grid::Unwrap(grid.ToObject())->_underlying));
+    }
+    return getPackedBuffers(env, grids);
+}
+
+Napi::Value MeshBufferPool::Clear_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value MeshBufferPool::Clear(const Napi::CallbackInfo &info)
+{
+    GridPool::Instance().Clear();
+    return info.Env().Undefined();
+}
+
+Napi::Value MeshBufferPool::Count_async(const Napi::CallbackInfo &info)
+{
+    return info.Env().Undefined();
+}
+
+Napi::Value MeshBufferPool::Count(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), GridPool::Instance().Count());
+}
+
+SolidTessellator::SolidTessellator(const MbSolid &solid, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly, bool cache)
+    : solid(solid), stepData(stepData), formNote(formNote), outlinesOnly(outlinesOnly), cache(cache), mesh(new MbMesh(false)), failed(false)
+{
+    solid.AddRef();
+    mesh->AddRef();
+    solid.GetFaces(faces);
+    solid.GetEdges(edges);
+    skipFaces.resize(faces.Count(), false);
+    skipEdges.resize(edges.Count(), false);
+}
+
+SolidTessellator::~SolidTessellator()
+{
+    for (size_t i = 0; i < edgeMeshes.size(); i++)
+        if (edgeMeshes[i] != NULL)
+            edgeMeshes[i]->Release();
+    mesh->Release();
+    solid.Release();
+}
+
+bool SolidTessellator::Calculate()
+{
+    std::vector<TessellationJob> jobs;
+    Prepare(jobs);
+    RunAll(jobs);
+    return Finish();
+}
+
+void SolidTessellator::Prepare(std::vector<TessellationJob> &jobs)
+{
+    const size_t faceCount = faces.Count();
+    const size_t edgeCount = edges.Count();
+
+    // Grids are added to the mesh up front because the mesh itself is not thread safe.
+    // Without cache the GridCache isn't consulted at all, so keys aren't computed and no misses are counted.
+    GridCache &gridCache = GridCache::Instance();
+    GridPool &pool = GridPool::Instance();
+    if (cache)
+        gridCache.Claim(solid);
+    grids.resize(faceCount, NULL);
+    keys.resize(faceCount, 0);
+    cached.resize(faceCount, false);
+    faceBounds.resize(GRID_BOUNDS_STRIDE * faceCount, 0);
+    for (size_t i = 0; i < faceCount; i++)
+    {
+        if (skipFaces[i])
+            continue;
+
+        MbFace *face = faces[i];
+        MbGrid *grid = NULL;
+        if (cache)
+        {
+            keys[i] = GridCache::Key(*face, FaceStepData(i), formNote);
+            grid = gridCache.Get(keys[i]);
+        }
+        cached[i] = grid != NULL;
+        if (grid != NULL)
+            mesh->AddGrid(*grid);
+        else if ((grid = pool.Take()) != NULL)
+        {
+            mesh->AddGrid(*grid);
+            grid->Release();
+        }
+        else
+            grid = mesh->AddGrid();
+        face->AttributesConvert(*grid);
+        grid->SetItem(face);
+        grid->SetPrimitiveName(face->GetNameHash());
+        grid->SetPrimitiveType(rt_TopItem);
+        grid->SetStepData(FaceStepData(i));
+        grids[i] = grid;
+        gridFaces.push_back(i);
+        if (cached[i])
+        {
+            getGridBounds(*grid, &faceBounds[GRID_BOUNDS_STRIDE * i]);
+            continue;
+        }
+
+        MbCube cube;
+        face->AddYourGabaritTo(cube);
+        TessellationJob job = {this, i, cube.IsEmpty() ? 0 : cube.pmin.DistanceToPoint(cube.pmax)};
+        jobs.push_back(job);
+    }
+    edgeMeshes.resize(edgeCount, NULL);
+    for (size_t i = 0; i < edgeCount; i++)
+    {
+        if (skipEdges[i])
+            continue;
+        edgeMeshes[i] = new MbMesh(false);
+        edgeMeshes[i]->AddRef();
+        // Edges are cheap, so they go last
+        TessellationJob job = {this, faceCount + i, -1};
+        jobs.push_back(job);
+    }
+}
+
+void SolidTessellator::Run(size_t k)
+{
+    const size_t faceCount = faces.Count();
+    try
+    {
+        if (k < faceCount)
+        {
+            ::CalculateGrid(*faces[k], FaceStepData(k), *grids[k], false, formNote.Quad(), formNote.Fair());
+            getGridBounds(*grids[k], &faceBounds[GRID_BOUNDS_STRIDE * k]);
+        }
+        else
+            edges[k - faceCount]->CalculateMesh(EdgeStepData(k - faceCount), formNote, *edgeMeshes[k - faceCount]);
+    }
+    catch (...)
+    {
+        failed = true;
+    }
+}
+
+bool SolidTessellator::Finish()
+{
+    if (failed)
+        return false;
+    // Per face precisions come from a view, and so are unlikely to be asked for again.
+    if (!cache || !faceStepDatas.empty())
+        return true;
+    GridCache &gridCache = GridCache::Instance();
+    for (size_t i = 0; i < grids.size(); i++)
+        if (grids[i] != NULL && !cached[i])
+            gridCache.Put(keys[i], *grids[i]);
+    return true;
+}
+
+void SolidTessellator::RunAll(std::vector<TessellationJob> &jobs)
+{
+    // Largest faces first, so that a big face never starts last.
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) { return jobs[a].size > jobs[b].size; });
+
+    auto work = [&jobs](size_t i)
+    {
+        jobs[i].tessellator->Run(jobs[i].k);
+        jobs[i].tessellator->Ran(jobs[i].k);
+    };
+
+    EnterParallelRegion();
+    ParallelFor(order, work);
+    ExitParallelRegion();
+}
+
+Napi::Object SolidTessellator::ToJs(const Napi::Env env)
+{
+    // One packed array for all faces; each face's buffer gets a view of its own row.
+    const size_t gCount = mesh->GridsCount();
+    Napi::Float32Array bounds = Napi::Float32Array::New(env, GRID_BOUNDS_STRIDE * gCount);
+    Napi::Array jsFaces = Napi::Array::New(env);
+    for (size_t g = 0; g < gCount; g++)
+    {
+        Napi::Object jsFace = getBuffer(env, gridFaces[g], mesh->SetGrid(g), mesh);
+        memcpy(bounds.Data() + GRID_BOUNDS_STRIDE * g, &faceBounds[GRID_BOUNDS_STRIDE * gridFaces[g]], sizeof(float) * GRID_BOUNDS_STRIDE);
+        jsFace.Set(Napi::String::New(env, "bounds"), Napi::Float32Array::New(env, GRID_BOUNDS_STRIDE, bounds.ArrayBuffer(), sizeof(float) * GRID_BOUNDS_STRIDE * g));
+        jsFaces[g] = jsFace;
+    }
+
+    Napi::Array jsEdges = Napi::Array::New(env);
+    edgeIndices.clear();
+    for (size_t i = 0, j = 0; i < edgeMeshes.size(); i++)
+    {
+        Napi::Object jsInfo;
+        if (!EdgeToJs(env, i, jsInfo))
+            continue;
+        jsEdges[j++] = jsInfo;
+        edgeIndices.push_back(i);
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "faces"), jsFaces);
+    result.Set(Napi::String::New(env, "bounds"), bounds);
+    result.Set(Napi::String::New(env, "edges"), jsEdges);
+    return result;
+}
+
+// NOTE: like Mesh::GetEdges, only the first polygon of each edge is used.
+bool SolidTessellator::EdgeToJs(const Napi::Env env, size_t i, Napi::Object &result)
+{
+    MbMesh *edgeMesh = edgeMeshes[i];
+    if (edgeMesh == NULL)
+        return false;
+    for (size_t k = 0, kCount = edgeMesh->PolygonsCount(); k < kCount; k++)
+    {
+        const MbPolygon3D *polygon = edgeMesh->GetPolygon(k);
+        if (polygon == NULL)
+            continue;
+
+        Napi::Object jsInfo = Napi::Object::New(env);
+        if (!getEdgeBuffer(env, polygon, outlinesOnly, jsInfo))
+            continue;
+
+        jsInfo.Set(Napi::String::New(env, "i"), Napi::Number::New(env, i));
+        jsInfo.Set(Napi::String::New(env, "model"), CurveEdge::NewInstance(env, edges[i]));
+        result = jsInfo;
+        return true;
+    }
+    return false;
+}
+
+template <typename Tessellator>
+class Tessellate_AsyncWorker : public PromiseWorker
+{
+public:
+    Tessellate_AsyncWorker(Napi::Promise::Deferred const &d, Tessellator *tessellator, const char *name)
+        : PromiseWorker(d), tessellator(tessellator), name(name) {}
+    virtual ~Tessellate_AsyncWorker() { delete tessellator; }
+
+    void Execute() override
+    {
+        if (!tessellator->Calculate())
+            SetError(std::string("Operation ") + name + " failed");
+    }
+
+    void Resolve(Napi::Promise::Deferred const &deferred) override
+    {
+        deferred.Resolve(tessellator->ToJs(deferred.Env()));
+    }
+
+    void Reject(Napi::Promise::Deferred const &deferred, Napi::Error const &error) override
+    {
+        error.Value()["isC3dError"] = true;
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Tessellator *tessellator;
+    const char *name;
+};
+
+static bool getTessellationParams(const Napi::CallbackInfo &info, size_t first, const MbStepData *&stepData, const MbFormNote *&formNote, bool &outlinesOnly)
+{
+    Napi::Env env = info.Env();
+    if (!(info[first].IsObject() && info[first].ToObject().InstanceOf(StepData::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "StepData stepData is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (!(info[first + 1].IsObject() && info[first + 1].ToObject().InstanceOf(FormNote::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "FormNote formNote is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (!info[first + 2].IsBoolean())
+    {
+        Napi::Error::New(env, "boolean outlinesOnly is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    stepData = StepData::Unwrap(info[first].ToObject())->_underlying;
+    formNote = FormNote::Unwrap(info[first + 1].ToObject())->_underlying;
+    outlinesOnly = info[first + 2].ToBoolean();
+    return true;
+}
+
+static SolidTessellator *newSolidTessellator(const MbSolid &solid, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3 && info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 3 or 4 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+
+    const MbStepData *stepData;
+    const MbFormNote *formNote;
+    bool outlinesOnly;
+    if (!getTessellationParams(info, 0, stepData, formNote, outlinesOnly))
+        return NULL;
+    if (info.Length() == 4 && !info[3].IsBoolean())
+    {
+        Napi::Error::New(env, "boolean cache is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    return new SolidTessellator(solid, *stepData, *formNote, outlinesOnly, info.Length() == 4 && info[3].ToBoolean());
+}
+
+Napi::Value Solid::TessellateParallel(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    SolidTessellator *tessellator = newSolidTessellator(*_underlying, info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation TessellateParallel failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value Solid::TessellateParallel_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    SolidTessellator *tessellator = newSolidTessellator(*_underlying, info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<SolidTessellator> *asyncWorker = new Tessellate_AsyncWorker<SolidTessellator>(deferred, tessellator, "TessellateParallel");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+InstancedTessellator::InstancedTessellator(const MbSolid &solid, const DuplicationValues &params, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly)
+    : SolidTessellator(solid, stepData, formNote, outlinesOnly)
+{
+    params.GenerateTransformMatrices(matrices);
+}
+
+Napi::Object InstancedTessellator::ToJs(const Napi::Env env)
+{
+    Napi::Object result = SolidTessellator::ToJs(env);
+
+    // Row by row, which (as MbMatrix3D transforms row vectors) is the column-major order of THREE.Matrix4.fromArray
+    Napi::Float32Array jsMatrices = Napi::Float32Array::New(env, 16 * matrices.size());
+    float *data = jsMatrices.Data();
+    for (size_t k = 0; k < matrices.size(); k++)
+        for (size_t r = 0; r < 4; r++)
+            for (size_t c = 0; c < 4; c++)
+                data[16 * k + 4 * r + c] = (float)matrices[k].El(r, c);
+    result.Set(Napi::String::New(env, "matrices"), jsMatrices);
+    return result;
+}
+
+static InstancedTessellator *newInstancedTessellator(const MbSolid &solid, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 4 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!(info[0].IsObject() && info[0].ToObject().InstanceOf(_DuplicationValues::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "DuplicationValues params is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+
+    const MbStepData *stepData;
+    const MbFormNote *formNote;
+    bool outlinesOnly;
+    if (!getTessellationParams(info, 1, stepData, formNote, outlinesOnly))
+        return NULL;
+    const DuplicationValues *params = _DuplicationValues::Unwrap(info[0].ToObject())->_underlying;
+    return new InstancedTessellator(solid, *params, *stepData, *formNote, outlinesOnly);
+}
+
+Napi::Value Solid::TessellateInstanced(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    InstancedTessellator *tessellator = newInstancedTessellator(*_underlying, info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation TessellateInstanced failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value Solid::TessellateInstanced_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    InstancedTessellator *tessellator = newInstancedTessellator(*_underlying, info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<InstancedTessellator> *asyncWorker = new Tessellate_AsyncWorker<InstancedTessellator>(deferred, tessellator, "TessellateInstanced");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+IncrementalTessellator::IncrementalTessellator(const MbSolid &solid, const std::vector<const SolidDuplicate *> &histories, const std::unordered_set<uint64_t> &knownFaces, const std::unordered_set<uint64_t> &knownEdges, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly)
+    : SolidTessellator(solid, stepData, formNote, outlinesOnly)
+{
+    const size_t faceCount = faces.Count();
+    const size_t edgeCount = edges.Count();
+    faceIds.resize(faceCount, 0);
+    edgeIds.resize(edgeCount, 0);
+
+    // The solid was made from exactly one of the copies; the first unchanged face tells which (latest first).
+    const SolidDuplicate *history = NULL;
+    for (size_t i = 0; i < faceCount && history == NULL; i++)
+    {
+        if (faces[i]->GetOwnChanged())
+            continue;
+        for (size_t h = histories.size(); h-- > 0;)
+        {
+            if (histories[h]->GetOriginalId(faces[i]) != 0)
+            {
+                history = histories[h];
+                break;
+            }
+        }
+    }
+    if (history == NULL)
+        return;
+
+    std::unordered_set<uint64_t> reusedFaces, reusedEdges;
+    for (size_t i = 0; i < faceCount; i++)
+    {
+        if (faces[i]->GetOwnChanged())
+            continue;
+        const uint64_t id = faceIds[i] = history->GetOriginalId(faces[i]);
+        if (id != 0 && knownFaces.count(id) > 0)
+        {
+            skipFaces[i] = true;
+            reusedFaces.insert(id);
+        }
+    }
+    for (size_t i = 0; i < edgeCount; i++)
+    {
+        if (edges[i]->GetOwnChanged())
+            continue;
+        const uint64_t id = edgeIds[i] = history->GetOriginalId(edges[i]);
+        if (id != 0 && knownEdges.count(id) > 0)
+        {
+            skipEdges[i] = true;
+            reusedEdges.insert(id);
+        }
+    }
+
+    for (std::unordered_set<uint64_t>::const_iterator i = knownFaces.begin(); i != knownFaces.end(); ++i)
+        if (reusedFaces.count(*i) == 0)
+            removedFaceIds.push_back(*i);
+    for (std::unordered_set<uint64_t>::const_iterator i = knownEdges.begin(); i != knownEdges.end(); ++i)
+        if (reusedEdges.count(*i) == 0)
+            removedEdgeIds.push_back(*i);
+}
+
+static Napi::BigInt64Array toBigInt64Array(const Napi::Env env, const std::vector<uint64_t> &ids)
+{
+    Napi::BigInt64Array result = Napi::BigInt64Array::New(env, ids.size());
+    if (ids.size() > 0)
+        memcpy(result.Data(), &ids[0], sizeof(uint64_t) * ids.size());
+    return result;
+}
+
+Napi::Object IncrementalTessellator::ToJs(const Napi::Env env)
+{
+    Napi::Object result = SolidTessellator::ToJs(env);
+
+    std::vector<uint64_t> ids, reusedIds;
+    std::vector<uint32_t> reused;
+    for (size_t g = 0; g < gridFaces.size(); g++)
+        ids.push_back(faceIds[gridFaces[g]]);
+    for (size_t i = 0; i < skipFaces.size(); i++)
+        if (skipFaces[i])
+        {
+            reused.push_back((uint32_t)i);
+            reusedIds.push_back(faceIds[i]);
+        }
+    Napi::Uint32Array reusedFaces = Napi::Uint32Array::New(env, reused.size());
+    std::copy(reused.begin(), reused.end(), reusedFaces.Data());
+    result.Set(Napi::String::New(env, "faceIds"), toBigInt64Array(env, ids));
+    result.Set(Napi::String::New(env, "reusedFaces"), reusedFaces);
+    result.Set(Napi::String::New(env, "reusedFaceIds"), toBigInt64Array(env, reusedIds));
+    result.Set(Napi::String::New(env, "removedFaceIds"), toBigInt64Array(env, removedFaceIds));
+
+    ids.clear();
+    reusedIds.clear();
+    reused.clear();
+    for (size_t e = 0; e < edgeIndices.size(); e++)
+        ids.push_back(edgeIds[edgeIndices[e]]);
+    for (size_t i = 0; i < skipEdges.size(); i++)
+        if (skipEdges[i])
+        {
+            reused.push_back((uint32_t)i);
+            reusedIds.push_back(edgeIds[i]);
+        }
+    Napi::Uint32Array reusedEdges = Napi::Uint32Array::New(env, reused.size());
+    std::copy(reused.begin(), reused.end(), reusedEdges.Data());
+    result.Set(Napi::String::New(env, "edgeIds"), toBigInt64Array(env, ids));
+    result.Set(Napi::String::New(env, "reusedEdges"), reusedEdges);
+    result.Set(Napi::String::New(env, "reusedEdgeIds"), toBigInt64Array(env, reusedIds));
+    result.Set(Napi::String::New(env, "removedEdgeIds"), toBigInt64Array(env, removedEdgeIds));
+
+    return result;
+}
+
+static bool getKnownIds(const Napi::Env env, const Napi::Object known, const char *key, std::unordered_set<uint64_t> &result)
+{
+    Napi::Value value = known.Get(key);
+    if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_bigint64_array)
+    {
+        Napi::Error::New(env, std::string("BigInt64Array known.") + key + " is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::BigInt64Array ids = value.As<Napi::BigInt64Array>();
+    const int64_t *data = ids.Data();
+    for (size_t i = 0, count = ids.ElementLength(); i < count; i++)
+        result.insert((uint64_t)data[i]);
+    return true;
+}
+
+static IncrementalTessellator *newIncrementalTessellator(const MbSolid &solid, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 5)
+    {
+        Napi::Error::New(env, "Expecting 5 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[0].IsArray())
+    {
+        Napi::Error::New(env, "SolidDuplicate[] histories is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<const SolidDuplicate *> histories;
+    Napi::Array histories_ = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < histories_.Length(); i++)
+    {
+        Napi::Value history = histories_[i];
+        if (!(history.IsObject() && history.ToObject().InstanceOf(_SolidDuplicate::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "SolidDuplicate[] histories is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        histories.push_back(_SolidDuplicate::Unwrap(history.ToObject())->_underlying);
+    }
+    if (!info[1].IsObject())
+    {
+        Napi::Error::New(env, "KnownTessellation known is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::unordered_set<uint64_t> knownFaces, knownEdges;
+    if (!getKnownIds(env, info[1].ToObject(), "faces", knownFaces) || !getKnownIds(env, info[1].ToObject(), "edges", knownEdges))
+        return NULL;
+
+    const MbStepData *stepData;
+    const MbFormNote *formNote;
+    bool outlinesOnly;
+    if (!getTessellationParams(info, 2, stepData, formNote, outlinesOnly))
+        return NULL;
+    return new IncrementalTessellator(solid, histories, knownFaces, knownEdges, *stepData, *formNote, outlinesOnly);
+}
+
+Napi::Value Solid::TessellateIncremental(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    IncrementalTessellator *tessellator = newIncrementalTessellator(*_underlying, info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation TessellateIncremental failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value Solid::TessellateIncremental_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    IncrementalTessellator *tessellator = newIncrementalTessellator(*_underlying, info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<IncrementalTessellator> *asyncWorker = new Tessellate_AsyncWorker<IncrementalTessellator>(deferred, tessellator, "TessellateIncremental");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+TessellatorGroup::~TessellatorGroup()
+{
+    for (size_t m = 0; m < members.size(); m++)
+        delete members[m];
+}
+
+// A single pass over the threads means the small faces of one member fill in the gaps left by the big
+// faces of another, instead of each member waiting on its slowest face.
+bool TessellatorGroup::Calculate()
+{
+    std::vector<TessellationJob> jobs;
+    for (size_t m = 0; m < members.size(); m++)
+        members[m]->Prepare(jobs);
+    SolidTessellator::RunAll(jobs);
+    bool success = true;
+    for (size_t m = 0; m < members.size(); m++)
+        success = members[m]->Finish() && success;
+    return success;
+}
+
+Napi::Object TessellatorGroup::ToJs(const Napi::Env env)
+{
+    Napi::Array result = Napi::Array::New(env, members.size());
+    for (size_t m = 0; m < members.size(); m++)
+        result[m] = members[m]->ToJs(env);
+    return result;
+}
+
+// NOTE: CalculateGrid has no way to share samples between precisions, so what the levels share is the
+// enumeration of faces and edges and the single pass over the threads.
+SolidLevelsTessellator::SolidLevelsTessellator(const MbSolid &solid, const std::vector<MbStepData> &stepDatas, const MbFormNote &formNote, bool outlinesOnly, bool cache)
+{
+    for (size_t l = 0; l < stepDatas.size(); l++)
+        members.push_back(new SolidTessellator(solid, stepDatas[l], formNote, outlinesOnly, cache));
+}
+
+static SolidLevelsTessellator *newSolidLevelsTessellator(const MbSolid &solid, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3 && info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 3 or 4 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[0].IsArray())
+    {
+        Napi::Error::New(env, "StepData[] stepDatas is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<MbStepData> stepDatas;
+    Napi::Array stepDatas_ = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < stepDatas_.Length(); i++)
+    {
+        Napi::Value stepData = stepDatas_[i];
+        if (!(stepData.IsObject() && stepData.ToObject().InstanceOf(StepData::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "StepData[] stepDatas is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        stepDatas.push_back(*StepData::Unwrap(stepData.ToObject())->_underlying);
+    }
+    if (!(info[1].IsObject() && info[1].ToObject().InstanceOf(FormNote::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "FormNote formNote is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[2].IsBoolean())
+    {
+        Napi::Error::New(env, "boolean outlinesOnly is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (info.Length() == 4 && !info[3].IsBoolean())
+    {
+        Napi::Error::New(env, "boolean cache is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbFormNote *formNote = FormNote::Unwrap(info[1].ToObject())->_underlying;
+    return new SolidLevelsTessellator(solid, stepDatas, *formNote, info[2].ToBoolean(), info.Length() == 4 && info[3].ToBoolean());
+}
+
+Napi::Value Solid::TessellateLevels(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    SolidLevelsTessellator *tessellator = newSolidLevelsTessellator(*_underlying, info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation TessellateLevels failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value Solid::TessellateLevels_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    SolidLevelsTessellator *tessellator = newSolidLevelsTessellator(*_underlying, info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<SolidLevelsTessellator> *asyncWorker = new Tessellate_AsyncWorker<SolidLevelsTessellator>(deferred, tessellator, "TessellateLevels");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+GridChunkWriter::GridChunkWriter(const std::vector<const MbSolid *> &solids, const std::vector<MbStepData> &stepDatas, const MbFormNote &formNote)
+    : solids(solids), stepDatas(stepDatas), formNote(formNote), data(NULL), length(0)
+{
+    for (size_t s = 0; s < solids.size(); s++)
+        solids[s]->AddRef();
+}
+
+GridChunkWriter::~GridChunkWriter()
+{
+    for (size_t s = 0; s < solids.size(); s++)
+        solids[s]->Release();
+    delete[] data;
+}
+
+// Layout (little-endian): magic, version and solid count as uint32; then for each solid its uint64 ItemHash and
+// its face and grid counts as uint32, followed by its grids. Each grid is its uint64 key, its point, normal and
+// triangle counts as uint32, the points and normals (3 floats each) and the triangles (3 uint32 each).
+bool GridChunkWriter::Calculate()
+{
+    // Only the faces are saved; edges are cheap enough to sample again
+    struct Section
+    {
+        uint64_t item;
+        uint32_t faceCount;
+        size_t begin, end;
+    };
+    struct Saved
+    {
+        uint64_t key;
+        MbFace *face;
+        const MbStepData *stepData;
+        MbGrid *grid;
+    };
+    GridCache &cache = GridCache::Instance();
+    std::vector<Section> sections;
+    std::vector<Saved> saved;
+    std::vector<size_t> missing;
+    std::unordered_set<uint64_t> items;
+    // Faces that aren't cached are tessellated into this, as SolidTessellator would
+    MbMesh *scratch = new MbMesh(false);
+    scratch->AddRef();
+    for (size_t s = 0; s < solids.size(); s++)
+    {
+        // Identical solids (say, copies) share one section
+        const uint64_t item = GridCache::ItemHash(*solids[s]);
+        if (!items.insert(item).second)
+            continue;
+        // The faces live as long as the solid, which is held until this is destroyed
+        RPArray<MbFace> faces;
+        solids[s]->GetFaces(faces);
+        Section section = {item, (uint32_t)faces.Count(), saved.size(), 0};
+        std::unordered_set<uint64_t> seen;
+        for (size_t i = 0; i < faces.Count(); i++)
+            for (size_t l = 0; l < stepDatas.size(); l++)
+            {
+                const uint64_t key = GridCache::Key(*faces[i], stepDatas[l], formNote);
+                if (!seen.insert(key).second)
+                    continue;
+                MbGrid *grid = cache.Find(key);
+                if (grid == NULL)
+                {
+                    grid = scratch->AddGrid();
+                    grid->AddRef();
+                    missing.push_back(saved.size());
+                }
+                Saved entry = {key, faces[i], &stepDatas[l], grid};
+                saved.push_back(entry);
+            }
+        section.end = saved.size();
+        sections.push_back(section);
+    }
+
+    std::atomic<bool> failed(false);
+    auto work = [&](size_t m)
+    {
+        const Saved &entry = saved[missing[m]];
+        try
+        {
+            ::CalculateGrid(*entry.face, *entry.stepData, *entry.grid, false, formNote.Quad(), formNote.Fair());
+        }
+        catch (...)
+        {
+            failed = true;
+        }
+    };
+    std::vector<size_t> order(missing.size());
+    for (size_t m = 0; m < order.size(); m++)
+        order[m] = m;
+    EnterParallelRegion();
+    ParallelFor(order, work);
+    ExitParallelRegion();
+
+    if (!failed)
+    {
+        length = 3 * sizeof(uint32_t) + sections.size() * (sizeof(uint64_t) + 2 * sizeof(uint32_t));
+        for (size_t g = 0; g < saved.size(); g++)
+        {
+            const MbGrid *grid = saved[g].grid;
+            const size_t normals = std::min(grid->PointsCount(), grid->NormalsCount());
+            length += sizeof(uint64_t) + 3 * sizeof(uint32_t) + 3 * sizeof(float) * (grid->PointsCount() + normals) + 3 * sizeof(uint32_t) * grid->TrianglesCount();
+        }
+
+        data = new char[length];
+        char *at = data;
+        putUint32(at, GRID_CHUNK_MAGIC);
+        putUint32(at, GRID_CHUNK_VERSION);
+        putUint32(at, (uint32_t)sections.size());
+        for (size_t s = 0; s < sections.size(); s++)
+        {
+            putUint64(at, sections[s].item);
+            putUint32(at, sections[s].faceCount);
+            putUint32(at, (uint32_t)(sections[s].end - sections[s].begin));
+            for (size_t g = sections[s].begin; g < sections[s].end; g++)
+            {
+                const MbGrid *grid = saved[g].grid;
+                const uint32_t points = (uint32_t)grid->PointsCount();
+                const uint32_t normals = (uint32_t)std::min(grid->PointsCount(), grid->NormalsCount());
+                const uint32_t triangles = (uint32_t)grid->TrianglesCount();
+                putUint64(at, saved[g].key);
+                putUint32(at, points);
+                putUint32(at, normals);
+                putUint32(at, triangles);
+                const float *p = (const float *)grid->GetFloatPointsAddr();
+                for (uint32_t j = 0; j < 3 * points; j++)
+                    putFloat(at, p[j]);
+                const float *n = (const float *)grid->GetFloatNormalsAddr();
+                for (uint32_t j = 0; j < 3 * normals; j++)
+                    putFloat(at, n[j]);
+                const uint32_t *t = (const uint32_t *)grid->GetTrianglesAddr();
+                for (uint32_t j = 0; j < 3 * triangles; j++)
+                    putUint32(at, t[j]);
+            }
+        }
+    }
+
+    for (size_t g = 0; g < saved.size(); g++)
+        saved[g].grid->Release();
+    scratch->Release();
+    return !failed;
+}
+
+Napi::Value GridChunkWriter::ToJs(const Napi::Env env)
+{
+    // The buffer takes over the memory
+    Napi::Buffer<char> result = Napi::Buffer<char>::New(env, data, length, [](Napi::Env, char *data)
+                                                         { delete[] data; });
+    data = NULL;
+    return result;
+}
+
+GridChunkReader::GridChunkReader(const Napi::Buffer<char> buffer)
+    : buffer(Napi::Persistent(buffer.ToObject())), data(buffer.Data()), length(buffer.Length()), loaded(0) {}
+
+bool GridChunkReader::Calculate()
+{
+    const char *at = data, *end = data + length;
+    if ((size_t)(end - at) < 3 * sizeof(uint32_t))
+        return false;
+    const uint32_t magic = getUint32(at), version = getUint32(at), sectionCount = getUint32(at);
+    if (magic != GRID_CHUNK_MAGIC)
+        return false;
+    // A chunk written by another version is a valid cache of nothing
+    if (version != GRID_CHUNK_VERSION)
+        return true;
+
+    // Grids past the budget would only evict the first ones read, so reading stops there
+    GridCache &cache = GridCache::Instance();
+    const size_t budget = cache.GetStats().budget;
+    size_t bytes = 0;
+    bool fits = true;
+    for (uint32_t s = 0; s < sectionCount && fits; s++)
+    {
+        if ((size_t)(end - at) < sizeof(uint64_t) + 2 * sizeof(uint32_t))
+            return false;
+        const uint64_t item = getUint64(at);
+        const uint32_t faceCount = getUint32(at), gridCount = getUint32(at);
+
+        std::vector<std::pair<uint64_t, MbGrid *>> grids;
+        bool valid = true;
+        for (uint32_t g = 0; g < gridCount && valid && fits; g++)
+        {
+            if ((size_t)(end - at) < sizeof(uint64_t) + 3 * sizeof(uint32_t))
+            {
+                valid = false;
+                break;
+            }
+            const uint64_t key = getUint64(at);
+            const uint32_t points = getUint32(at), normals = getUint32(at), triangles = getUint32(at);
+            if (normals > points || (size_t)(end - at) < 3 * sizeof(float) * ((size_t)points + normals) + 3 * sizeof(uint32_t) * (size_t)triangles)
+            {
+                valid = false;
+                break;
+            }
+
+            // A scratch mesh makes a grid of the same kind the tessellators produce
+            MbMesh *mesh = new MbMesh(false);
+            mesh->AddRef();
+            MbGrid *grid = mesh->AddGrid();
+            grid->AddRef();
+            mesh->Release();
+            for (size_t j = 0; j < points; j++)
+            {
+                const float x = getFloat(at), y = getFloat(at), z = getFloat(at);
+                grid->AddPoint(MbFloatPoint3D(x, y, z));
+            }
+            for (size_t j = 0; j < normals; j++)
+            {
+                const float x = getFloat(at), y = getFloat(at), z = getFloat(at);
+                grid->AddNormal(MbFloatVector3D(x, y, z));
+            }
+            for (size_t j = 0; j < triangles && valid; j++)
+            {
+                const uint32_t a = getUint32(at), b = getUint32(at), c = getUint32(at);
+                if (a >= points || b >= points || c >= points)
+                    valid = false;
+                else
+                    grid->AddTriangle(a, b, c);
+            }
+            fits = valid && (bytes += gridBytes(*grid)) <= budget;
+            if (fits)
+                grids.push_back(std::make_pair(key, grid));
+            else
+                grid->Release();
+        }
+
+        if (!valid)
+        {
+            for (size_t g = 0; g < grids.size(); g++)
+                grids[g].second->Release();
+            return false;
+        }
+        loaded += grids.size();
+        cache.Stash(item, faceCount, grids);
+    }
+    return true;
+}
+
+Napi::Value GridChunkReader::ToJs(const Napi::Env env)
+{
+    return Napi::Number::New(env, loaded);
+}
+
+static GridChunkWriter *newGridChunkWriter(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3)
+    {
+        Napi::Error::New(env, "Expecting 3 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[0].IsArray())
+    {
+        Napi::Error::New(env, "Solid[] solids is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<const MbSolid *> solids;
+    Napi::Array solids_ = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < solids_.Length(); i++)
+    {
+        Napi::Value solid = solids_[i];
+        if (!(solid.IsObject() && solid.ToObject().InstanceOf(Solid::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "Solid[] solids is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        solids.push_back(Solid::Unwrap(solid.ToObject())->_underlying);
+    }
+    if (!info[1].IsArray())
+    {
+        Napi::Error::New(env, "StepData[] stepDatas is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<MbStepData> stepDatas;
+    Napi::Array stepDatas_ = info[1].As<Napi::Array>();
+    for (uint32_t i = 0; i < stepDatas_.Length(); i++)
+    {
+        Napi::Value stepData = stepDatas_[i];
+        if (!(stepData.IsObject() && stepData.ToObject().InstanceOf(StepData::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "StepData[] stepDatas is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        stepDatas.push_back(*StepData::Unwrap(stepData.ToObject())->_underlying);
+    }
+    if (!(info[2].IsObject() && info[2].ToObject().InstanceOf(FormNote::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "FormNote formNote is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbFormNote *formNote = FormNote::Unwrap(info[2].ToObject())->_underlying;
+    return new GridChunkWriter(solids, stepDatas, *formNote);
+}
+
+Napi::Value TessellationCache::Save(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    GridChunkWriter *writer = newGridChunkWriter(info);
+    if (writer == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (writer->Calculate())
+        result = writer->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Save failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete writer;
+    return result;
+}
+
+Napi::Value TessellationCache::Save_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    GridChunkWriter *writer = newGridChunkWriter(info);
+    if (writer == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<GridChunkWriter> *asyncWorker = new Tessellate_AsyncWorker<GridChunkWriter>(deferred, writer, "Save");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+static GridChunkReader *newGridChunkReader(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBuffer())
+    {
+        Napi::Error::New(env, "Buffer data is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    return new GridChunkReader(info[0].As<Napi::Buffer<char>>());
+}
+
+Napi::Value TessellationCache::Load(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    GridChunkReader *reader = newGridChunkReader(info);
+    if (reader == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (reader->Calculate())
+        result = reader->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Load failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete reader;
+    return result;
+}
+
+Napi::Value TessellationCache::Load_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    GridChunkReader *reader = newGridChunkReader(info);
+    if (reader == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<GridChunkReader> *asyncWorker = new Tessellate_AsyncWorker<GridChunkReader>(deferred, reader, "Load");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+// An object of size s at depth d covers s * viewportHeight / (2 d tan(fov / 2)) pixels in perspective, and
+// s * viewportHeight / height in orthographic; the sag is pixelError pixels' worth of that at the cube's nearest
+// depth. Cubes straddling the eye get the finest precision and cubes behind it the coarsest.
+double ViewCamera::Sag(const MbCube &cube) const
+{
+    if (cube.IsEmpty())
+        return maxSag;
+
+    double worldPerPixel;
+    if (fov > 0)
+    {
+        double nearest = MB_MAXDOUBLE, farthest = -MB_MAXDOUBLE;
+        for (size_t i = 0; i < 8; i++)
+        {
+            const MbCartPoint3D corner(i & 1 ? cube.pmax.x : cube.pmin.x, i & 2 ? cube.pmax.y : cube.pmin.y, i & 4 ? cube.pmax.z : cube.pmin.z);
+            const double depth = MbVector3D(eye, corner) * direction;
+            nearest = std::min(nearest, depth);
+            farthest = std::max(farthest, depth);
+        }
+        if (farthest < 0)
+            return maxSag;
+        if (nearest <= 0)
+            return minSag;
+        worldPerPixel = 2 * nearest * tan(fov / 2) / viewportHeight;
+    }
+    else
+    {
+        worldPerPixel = height / viewportHeight;
+    }
+    return std::max(minSag, std::min(maxSag, pixelError * worldPerPixel));
+}
+
+ViewSolidTessellator::ViewSolidTessellator(const MbSolid &solid, const ViewCamera &camera, const MbFormNote &formNote, bool outlinesOnly)
+    : SolidTessellator(solid, MbStepData(ist_SpaceStep, camera.maxSag), formNote, outlinesOnly)
+{
+    for (size_t i = 0, count = faces.Count(); i < count; i++)
+    {
+        MbCube cube;
+        faces[i]->AddYourGabaritTo(cube);
+        faceStepDatas.push_back(MbStepData(ist_SpaceStep, camera.Sag(cube)));
+    }
+    for (size_t i = 0, count = edges.Count(); i < count; i++)
+    {
+        MbCube cube;
+        edges[i]->AddYourGabaritTo(cube);
+        edgeStepDatas.push_back(MbStepData(ist_SpaceStep, camera.Sag(cube)));
+    }
+}
+
+ViewTessellator::ViewTessellator(const std::vector<const MbSolid *> &solids, const ViewCamera &camera, const MbFormNote &formNote, bool outlinesOnly)
+{
+    for (size_t s = 0; s < solids.size(); s++)
+        members.push_back(new ViewSolidTessellator(*solids[s], camera, formNote, outlinesOnly));
+}
+
+static bool getViewCamera(const Napi::Env env, const Napi::Object object, ViewCamera &camera)
+{
+    if (!getTriple(env, object, "camera", "eye", camera.eye.x, camera.eye.y, camera.eye.z) ||
+        !getTriple(env, object, "camera", "direction", camera.direction.x, camera.direction.y, camera.direction.z) ||
+        !getNumber(env, object, "camera", "fov", camera.fov) ||
+        !getNumber(env, object, "camera", "height", camera.height) ||
+        !getNumber(env, object, "camera", "viewportHeight", camera.viewportHeight) ||
+        !getNumber(env, object, "camera", "pixelError", camera.pixelError) ||
+        !getNumber(env, object, "camera", "minSag", camera.minSag) ||
+        !getNumber(env, object, "camera", "maxSag", camera.maxSag))
+        return false;
+
+    if (camera.viewportHeight <= 0 || camera.pixelError <= 0 || camera.minSag <= 0 || camera.maxSag < camera.minSag || (camera.fov <= 0 && camera.height <= 0))
+    {
+        Napi::Error::New(env, "ViewCamera camera is invalid.").ThrowAsJavaScriptException();
+        return false;
+    }
+    camera.direction.Normalize();
+    return true;
+}
+
+static ViewTessellator *newViewTessellator(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 4 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[0].IsArray())
+    {
+        Napi::Error::New(env, "Solid[] solids is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    std::vector<const MbSolid *> solids;
+    Napi::Array solids_ = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < solids_.Length(); i++)
+    {
+        Napi::Value solid = solids_[i];
+        if (!(solid.IsObject() && solid.ToObject().InstanceOf(Solid::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "Solid[] solids is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        solids.push_back(Solid::Unwrap(solid.ToObject())->_underlying);
+    }
+    ViewCamera camera;
+    if (!info[1].IsObject())
+    {
+        Napi::Error::New(env, "ViewCamera camera is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!getViewCamera(env, info[1].ToObject(), camera))
+        return NULL;
+    if (!(info[2].IsObject() && info[2].ToObject().InstanceOf(FormNote::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "FormNote formNote is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[3].IsBoolean())
+    {
+        Napi::Error::New(env, "boolean outlinesOnly is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbFormNote *formNote = FormNote::Unwrap(info[2].ToObject())->_underlying;
+    return new ViewTessellator(solids, camera, *formNote, info[3].ToBoolean());
+}
+
+Napi::Value ViewTessellation::Tessellate(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    ViewTessellator *tessellator = newViewTessellator(info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Tessellate failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value ViewTessellation::Tessellate_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    ViewTessellator *tessellator = newViewTessellator(info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<ViewTessellator> *asyncWorker = new Tessellate_AsyncWorker<ViewTessellator>(deferred, tessellator, "Tessellate");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+RegionTessellator::RegionTessellator(const std::vector<const MbRegion *> &regions, const MbPlacement3D &placement, const MbStepData &stepData, const MbFormNote &formNote)
+    : stepData(stepData), formNote(formNote)
+{
+    for (size_t k = 0; k < regions.size(); k++)
+    {
+        MbPlaneInstance *instance = new MbPlaneInstance(*regions[k], placement);
+        instance->AddRef();
+        instances.push_back(instance);
+        MbMesh *mesh = new MbMesh(false);
+        mesh->AddRef();
+        meshes.push_back(mesh);
+
+        size_t size = 0;
+        for (size_t c = 0, cCount = regions[k]->GetContoursCount(); c < cCount; c++)
+            size += regions[k]->GetContour(c)->GetSegmentsCount();
+        sizes.push_back(size);
+    }
+}
+
+RegionTessellator::~RegionTessellator()
+{
+    for (size_t k = 0; k < instances.size(); k++)
+    {
+        meshes[k]->Release();
+        instances[k]->Release();
+    }
+}
+
+bool RegionTessellator::Calculate()
+{
+    std::vector<size_t> order(instances.size());
+    for (size_t k = 0; k < order.size(); k++)
+        order[k] = k;
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b)
+              { return sizes[a] > sizes[b]; });
+
+    std::atomic<bool> failed(false);
+    ParallelFor(order, [&](size_t k)
+                {
+                    try
+                    {
+                        instances[k]->CalculateMesh(stepData, formNote, *meshes[k]);
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                    }
+                });
+    return !failed;
+}
+
+Napi::Object RegionTessellator::ToJs(const Napi::Env env)
+{
+    // Region k is groups[4k] indices from groups[4k + 1], over groups[4k + 3] points from groups[4k + 2];
+    // its indices count from its own first point.
+    const size_t count = meshes.size();
+    Napi::Uint32Array groups = Napi::Uint32Array::New(env, 4 * count);
+    size_t indexCount = 0, pointsCount = 0, maxPoints = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        size_t points = 0;
+        groups[4 * k + 0] = (uint32_t)indexCount;
+        groups[4 * k + 2] = (uint32_t)pointsCount;
+        for (size_t g = 0, gCount = meshes[k]->GridsCount(); g < gCount; g++)
+        {
+            const MbGrid *grid = meshes[k]->GetGrid(g);
+            indexCount += 3 * grid->TrianglesCount();
+            points += grid->PointsCount();
+        }
+        groups[4 * k + 1] = (uint32_t)(indexCount - groups[4 * k + 0]);
+        groups[4 * k + 3] = (uint32_t)points;
+        pointsCount += points;
+        maxPoints = std::max(maxPoints, points);
+    }
+
+    Napi::Float32Array position = Napi::Float32Array::New(env, 3 * pointsCount);
+    Napi::Float32Array normal = Napi::Float32Array::New(env, 3 * pointsCount);
+    std::vector<uint32_t> index(indexCount);
+    for (size_t k = 0; k < count; k++)
+    {
+        size_t indexAt = groups[4 * k + 0], pointAt = groups[4 * k + 2], base = 0;
+        for (size_t g = 0, gCount = meshes[k]->GridsCount(); g < gCount; g++)
+        {
+            const MbGrid *grid = meshes[k]->GetGrid(g);
+            const size_t points = grid->PointsCount();
+            const size_t normals = std::min(points, grid->NormalsCount());
+            memcpy(position.Data() + 3 * pointAt, grid->GetFloatPointsAddr(), sizeof(float) * 3 * points);
+            memcpy(normal.Data() + 3 * pointAt, grid->GetFloatNormalsAddr(), sizeof(float) * 3 * normals);
+            const size_t triangles = 3 * grid->TrianglesCount();
+            copyIndex(&index[indexAt], (const uint32_t *)grid->GetTrianglesAddr(), triangles, base);
+            indexAt += triangles;
+            pointAt += points;
+            base += points;
+        }
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    if (maxPoints <= SHORT_INDEX_LIMIT)
+    {
+        Napi::Uint16Array index16 = Napi::Uint16Array::New(env, indexCount);
+        std::copy(index.begin(), index.end(), index16.Data());
+        result.Set(Napi::String::New(env, "index"), index16);
+    }
+    else
+    {
+        Napi::Uint32Array index32 = Napi::Uint32Array::New(env, indexCount);
+        std::copy(index.begin(), index.end(), index32.Data());
+        result.Set(Napi::String::New(env, "index"), index32);
+    }
+    result.Set(Napi::String::New(env, "position"), position);
+    result.Set(Napi::String::New(env, "normal"), normal);
+    result.Set(Napi::String::New(env, "groups"), groups);
+    return result;
+}
+
+static RegionTessellator *newRegionTessellator(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 4 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[0].IsArray())
+    {
+        Napi::Error::New(env, "Region[] regions is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const Napi::Array regions_ = info[0].As<Napi::Array>();
+    std::vector<const MbRegion *> regions;
+    for (uint32_t i = 0; i < regions_.Length(); i++)
+    {
+        const Napi::Value region = regions_[i];
+        if (!(region.IsObject() && region.ToObject().InstanceOf(Region::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "Region[] regions is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        regions.push_back(Region::Unwrap(region.ToObject())->_underlying);
+    }
+    if (!(info[1].IsObject() && info[1].ToObject().InstanceOf(Placement3D::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "Placement3D placement is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!(info[2].IsObject() && info[2].ToObject().InstanceOf(StepData::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "StepData stepData is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!(info[3].IsObject() && info[3].ToObject().InstanceOf(FormNote::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "FormNote formNote is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbPlacement3D *placement = Placement3D::Unwrap(info[1].ToObject())->_underlying;
+    const MbStepData *stepData = StepData::Unwrap(info[2].ToObject())->_underlying;
+    const MbFormNote *formNote = FormNote::Unwrap(info[3].ToObject())->_underlying;
+    return new RegionTessellator(regions, *placement, *stepData, *formNote);
+}
+
+Napi::Value RegionTessellation::Tessellate(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    RegionTessellator *tessellator = newRegionTessellator(info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Tessellate failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value RegionTessellation::Tessellate_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    RegionTessellator *tessellator = newRegionTessellator(info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<RegionTessellator> *asyncWorker = new Tessellate_AsyncWorker<RegionTessellator>(deferred, tessellator, "Tessellate");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+CurveTessellator::CurveTessellator(const std::vector<const MbSpaceInstance *> &instances, const MbStepData &stepData, const MbFormNote &formNote)
+    : stepData(stepData), formNote(formNote), instances(instances)
+{
+    for (size_t k = 0; k < instances.size(); k++)
+    {
+        instances[k]->AddRef();
+        MbMesh *mesh = new MbMesh(false);
+        mesh->AddRef();
+        meshes.push_back(mesh);
+    }
+}
+
+CurveTessellator::~CurveTessellator()
+{
+    for (size_t k = 0; k < instances.size(); k++)
+    {
+        meshes[k]->Release();
+        instances[k]->Release();
+    }
+}
+
+bool CurveTessellator::Calculate()
+{
+    std::vector<size_t> order(instances.size());
+    for (size_t k = 0; k < order.size(); k++)
+        order[k] = k;
+
+    std::atomic<bool> failed(false);
+    ParallelFor(order, [&](size_t k)
+                {
+                    try
+                    {
+                        instances[k]->CalculateMesh(stepData, formNote, *meshes[k]);
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                    }
+                });
+    return !failed;
+}
+
+Napi::Object CurveTessellator::ToJs(const Napi::Env env)
+{
+    std::vector<const MbPolygon3D *> polygons;
+    std::vector<SimpleName> names;
+    Napi::Uint32Array items = Napi::Uint32Array::New(env, meshes.size() + 1);
+    for (size_t k = 0; k < meshes.size(); k++)
+    {
+        items[k] = (uint32_t)polygons.size();
+        for (size_t p = 0, pCount = meshes[k]->PolygonsCount(); p < pCount; p++)
+        {
+            const MbPolygon3D *polygon = meshes[k]->GetPolygon(p);
+            if (polygon == NULL || !isDisplayedPolygon(polygon, false))
+                continue;
+            polygons.push_back(polygon);
+            names.push_back(polygon->GetPrimitiveName());
+        }
+    }
+    items[meshes.size()] = (uint32_t)polygons.size();
+
+    Napi::Object result = getPackedEdges(env, polygons, names);
+    result.Set(Napi::String::New(env, "items"), items);
+    return result;
+}
+
+static CurveTessellator *newCurveTessellator(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 3)
+    {
+        Napi::Error::New(env, "Expecting 3 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!info[0].IsArray())
+    {
+        Napi::Error::New(env, "SpaceInstance[] instances is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const Napi::Array instances_ = info[0].As<Napi::Array>();
+    std::vector<const MbSpaceInstance *> instances;
+    for (uint32_t i = 0; i < instances_.Length(); i++)
+    {
+        const Napi::Value instance = instances_[i];
+        if (!(instance.IsObject() && instance.ToObject().InstanceOf(SpaceInstance::GetConstructor(env))))
+        {
+            Napi::Error::New(env, "SpaceInstance[] instances is required.").ThrowAsJavaScriptException();
+            return NULL;
+        }
+        instances.push_back(SpaceInstance::Unwrap(instance.ToObject())->_underlying);
+    }
+    if (!(info[1].IsObject() && info[1].ToObject().InstanceOf(StepData::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "StepData stepData is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!(info[2].IsObject() && info[2].ToObject().InstanceOf(FormNote::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "FormNote formNote is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbStepData *stepData = StepData::Unwrap(info[1].ToObject())->_underlying;
+    const MbFormNote *formNote = FormNote::Unwrap(info[2].ToObject())->_underlying;
+    return new CurveTessellator(instances, *stepData, *formNote);
+}
+
+Napi::Value CurveTessellation::Tessellate(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    CurveTessellator *tessellator = newCurveTessellator(info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation Tessellate failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value CurveTessellation::Tessellate_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    CurveTessellator *tessellator = newCurveTessellator(info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<CurveTessellator> *asyncWorker = new Tessellate_AsyncWorker<CurveTessellator>(deferred, tessellator, "Tessellate");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
+
+// What a call through the thread-safe function asks for
+#define STREAM_FLUSH 0
+#define STREAM_DONE 1
+
+StreamingTessellator::StreamingTessellator(const MbSolid &solid, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly, const Napi::Object listener_, const Napi::Promise::Deferred *deferred)
+    : SolidTessellator(solid, stepData, formNote, outlinesOnly), listener(Napi::Persistent(listener_)),
+      deferred(deferred == NULL ? NULL : new Napi::Promise::Deferred(*deferred)), success(false) {}
+
+StreamingTessellator::~StreamingTessellator()
+{
+    delete deferred;
+}
+
+void StreamingTessellator::Start(const Napi::Env env, const MbSolid &solid, const MbStepData &stepData, const MbFormNote &formNote, bool outlinesOnly, const Napi::Object listener, const Napi::Promise::Deferred *deferred)
+{
+    StreamingTessellator *tessellator = new StreamingTessellator(solid, stepData, formNote, outlinesOnly, listener, deferred);
+    tessellator->stream = STREAM::New(env, Napi::Function(), "TessellateStreaming", 0, 1, tessellator,
+                                      [](Napi::Env, void *,
+                                         StreamingTessellator *tessellator) { // Finalizer used to clean threads up
+                                          tessellator->thread.join();
+                                          delete tessellator;
+                                      });
+    tessellator->thread = std::thread(&StreamingTessellator::Stream, tessellator);
+}
+
+static void callStream(STREAM &stream, size_t what)
+{
+    size_t *data = new size_t(what);
+    if (stream.NonBlockingCall(data) != napi_ok)
+        delete data;
+}
+
+void StreamingTessellator::Stream()
+{
+    std::vector<TessellationJob> jobs;
+    Prepare(jobs);
+    for (size_t g = 0; g < gridFaces.size(); g++)
+        faceGrids[gridFaces[g]] = g;
+
+    // Faces that came out of the GridCache have no job; they are ready right away.
+    std::unordered_set<size_t> scheduled;
+    for (size_t j = 0; j < jobs.size(); j++)
+        scheduled.insert(jobs[j].k);
+    for (size_t g = 0; g < gridFaces.size(); g++)
+        if (scheduled.count(gridFaces[g]) == 0)
+            Push(gridFaces[g]);
+
+    RunAll(jobs);
+    success = Finish();
+    callStream(stream, STREAM_DONE);
+    stream.Release();
+}
+
+void StreamingTessellator::Ran(size_t k)
+{
+    Push(k);
+}
+
+// Only the first of a run of pushes asks for a flush; everything pushed until that flush runs goes in the same batch.
+void StreamingTessellator::Push(size_t k)
+{
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        first = pending.empty();
+        pending.push_back(k);
+    }
+    if (first)
+        callStream(stream, STREAM_FLUSH);
+}
+
+void StreamingTessellator::Flush(const Napi::Env env, bool done)
+{
+    std::vector<size_t> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(pending);
+    }
+
+    Napi::Object listener_ = listener.Value();
+    if (!batch.empty())
+    {
+        const size_t faceCount = faces.Count();
+        Napi::Array jsFaces = Napi::Array::New(env);
+        Napi::Array jsEdges = Napi::Array::New(env);
+        for (size_t b = 0, f = 0, e = 0; b < batch.size(); b++)
+        {
+            const size_t k = batch[b];
+            Napi::Object jsInfo;
+            if (k < faceCount)
+            {
+                Napi::Object jsFace = getBuffer(env, k, mesh->SetGrid(faceGrids[k]), mesh);
+                Napi::Float32Array bounds = Napi::Float32Array::New(env, GRID_BOUNDS_STRIDE);
+                memcpy(bounds.Data(), &faceBounds[GRID_BOUNDS_STRIDE * k], sizeof(float) * GRID_BOUNDS_STRIDE);
+                jsFace.Set(Napi::String::New(env, "bounds"), bounds);
+                jsFaces[f++] = jsFace;
+            }
+            else if (EdgeToJs(env, k - faceCount, jsInfo))
+                jsEdges[e++] = jsInfo;
+        }
+        listener_.Get("batch").As<Napi::Function>().Call(listener_, {jsFaces, jsEdges});
+    }
+    if (!done)
+        return;
+
+    listener_.Get("done").As<Napi::Function>().Call(listener_, {Napi::Boolean::New(env, success)});
+    if (deferred == NULL)
+        return;
+    if (success)
+        deferred->Resolve(env.Undefined());
+    else
+    {
+        Napi::Error error = Napi::Error::New(env, "Operation TessellateStreaming failed");
+        error.Value()["isC3dError"] = true;
+        deferred->Reject(error.Value());
+    }
+}
+
+void CallStream(Napi::Env env, Napi::Function callback, StreamingTessellator *context, size_t *data)
+{
+    // Is the JavaScript environment still available to call into, eg. the TSFN is not aborted
+    if (env != nullptr && data != nullptr)
+        context->Flush(env, *data == STREAM_DONE);
+    delete data;
+}
+
+static bool getStream(const Napi::Env env, const Napi::Value stream)
+{
+    if (!stream.IsObject() || !stream.ToObject().Get("batch").IsFunction() || !stream.ToObject().Get("done").IsFunction())
+    {
+        Napi::Error::New(env, "TessellationStream stream is required.").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+Napi::Value Solid::TessellateStreaming(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 4 parameters").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const MbStepData *stepData;
+    const MbFormNote *formNote;
+    bool outlinesOnly;
+    if (!getTessellationParams(info, 0, stepData, formNote, outlinesOnly) || !getStream(env, info[3]))
+        return env.Undefined();
+
+    StreamingTessellator::Start(env, *_underlying, *stepData, *formNote, outlinesOnly, info[3].ToObject());
+    return env.Undefined();
+}
+
+Napi::Value Solid::TessellateStreaming_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    if (info.Length() != 4)
+    {
+        Napi::Error::New(env, "Expecting 4 parameters").ThrowAsJavaScriptException();
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+    const MbStepData *stepData;
+    const MbFormNote *formNote;
+    bool outlinesOnly;
+    if (!getTessellationParams(info, 0, stepData, formNote, outlinesOnly) || !getStream(env, info[3]))
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    StreamingTessellator::Start(env, *_underlying, *stepData, *formNote, outlinesOnly, info[3].ToObject(), &deferred);
+    return deferred.Promise();
+}
+
+ProgressiveTessellator::ProgressiveTessellator(const MbSolid &solid, const MbStepData &coarseStepData, const MbStepData &fine, const MbFormNote &formNote, bool outlinesOnly, const Napi::Object listener_)
+    : coarse(solid, coarseStepData, formNote, outlinesOnly), solid(solid), fine(fine), formNote(formNote), outlinesOnly(outlinesOnly), listener(Napi::Persistent(listener_)) {}
+
+bool ProgressiveTessellator::Calculate()
+{
+    return coarse.Calculate();
+}
+
+Napi::Object ProgressiveTessellator::ToJs(const Napi::Env env)
+{
+    Napi::Object result = coarse.ToJs(env);
+    StreamingTessellator::Start(env, solid, fine, formNote, outlinesOnly, listener.Value());
+    return result;
+}
+
+static ProgressiveTessellator *newProgressiveTessellator(const MbSolid &solid, const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() != 5)
+    {
+        Napi::Error::New(env, "Expecting 5 parameters").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    if (!(info[0].IsObject() && info[0].ToObject().InstanceOf(StepData::GetConstructor(env))))
+    {
+        Napi::Error::New(env, "StepData coarse is required.").ThrowAsJavaScriptException();
+        return NULL;
+    }
+    const MbStepData *fine;
+    const MbFormNote *formNote;
+    bool outlinesOnly;
+    if (!getTessellationParams(info, 1, fine, formNote, outlinesOnly))
+        return NULL;
+    if (!getStream(env, info[4]))
+        return NULL;
+    const MbStepData *coarse = StepData::Unwrap(info[0].ToObject())->_underlying;
+    return new ProgressiveTessellator(solid, *coarse, *fine, *formNote, outlinesOnly, info[4].ToObject());
+}
+
+Napi::Value Solid::TessellateProgressive(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    ProgressiveTessellator *tessellator = newProgressiveTessellator(*_underlying, info);
+    if (tessellator == NULL)
+        return env.Undefined();
+
+    Napi::Value result;
+    if (tessellator->Calculate())
+        result = tessellator->ToJs(env);
+    else
+    {
+        Napi::Error::New(env, "Operation TessellateProgressive failed").ThrowAsJavaScriptException();
+        result = env.Undefined();
+    }
+    delete tessellator;
+    return result;
+}
+
+Napi::Value Solid::TessellateProgressive_async(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    ProgressiveTessellator *tessellator = newProgressiveTessellator(*_underlying, info);
+    if (tessellator == NULL)
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+        return deferred.Promise();
+    }
+
+    Tessellate_AsyncWorker<ProgressiveTessellator> *asyncWorker = new Tessellate_AsyncWorker<ProgressiveTessellator>(deferred, tessellator, "TessellateProgressive");
+    asyncWorker->Queue();
+    return deferred.Promise();
+}
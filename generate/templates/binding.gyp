@@ -19,7 +19,12 @@
                 "./lib/c3d/src/MeshAddon.cc",
                 "./lib/c3d/src/ModelAddon.cc",
                 "./lib/c3d/src/ProgressIndicator.cc",
+                "./lib/c3d/src/MeshExportAddon.cc",
+                "./lib/c3d/src/MeshBVH.cc",
+                "./lib/c3d/src/CurveIntersectionAddon.cc",
+                "./lib/c3d/src/SolidIntersectionAddon.cc",
                 "./lib/c3d/src/SolidDuplicateAddon.cc",
+                "./lib/c3d/src/TessellationAddon.cc",
                 <%_ for (c of classes) if (!c.ignore) { _%>
                     "./lib/c3d/src/<%- c.cppClassName %>.cc",
                 <%_ } _%>
@@ -40,8 +40,10 @@ declare module "*c3d.node" {
         
     <%_ } _%>
 
+    // index is a Uint16Array whenever the grid's points fit, a Uint32Array otherwise. The arrays are views over
+    // native memory that stays alive as long as they do, so keeping grid (or the mesh) around is unnecessary.
     declare interface MeshBuffer {
-        index: Uint32Array;
+        index: Uint16Array | Uint32Array;
         position: Float32Array;
         normal: Float32Array;
         style: number;
@@ -49,6 +51,48 @@ declare module "*c3d.node" {
         i: number;
         grid: Grid;
         model: Face;
+        // Only from the solid tessellators: this face's row of SolidTessellation.bounds
+        bounds?: Float32Array;
+    }
+
+    // All grids of a mesh in one ArrayBuffer; indices are already rebased (and 16-bit if all points fit). groups has
+    // 5 entries per grid: start, count, i, style, simpleName.
+    declare interface PackedMeshBuffer {
+        index: Uint16Array | Uint32Array;
+        position: Float32Array;
+        normal: Float32Array;
+        groups: Uint32Array;
+    }
+
+    // The triangulations of several regions in one ArrayBuffer each. groups has 4 entries per region: index start,
+    // index count, point start, point count; a region's indices count from its own first point.
+    declare interface PackedRegionBuffer {
+        index: Uint16Array | Uint32Array;
+        position: Float32Array;
+        normal: Float32Array;
+        groups: Uint32Array;
+    }
+
+    // A PackedMeshBuffer whose coincident vertices (with agreeing normals) are shared across faces; groups
+    // still has one row per face and faceIndex has the face's i for each triangle.
+    declare interface WeldedMeshBuffer extends PackedMeshBuffer {
+        faceIndex: Uint32Array;
+    }
+
+    // position is 16-bit relative to the grid's bounding cube: offset + scale * position / 65535, i.e.
+    // a normalized Uint16 attribute under an object transform. normal is octahedral, 2 snorm16 per vertex.
+    declare interface QuantizedGridBuffer {
+        index: Uint16Array | Uint32Array;
+        position: Uint16Array;
+        normal: Int16Array;
+        offset: Float32Array;
+        scale: Float32Array;
+    }
+
+    declare interface QuantizedMeshBuffer extends QuantizedGridBuffer {
+        style: number;
+        simpleName: number;
+        i: number;
     }
 
     declare interface EdgeBuffer {
@@ -59,6 +103,120 @@ declare module "*c3d.node" {
         model: c3d.CurveEdge
     }
 
+    // All displayed polylines of a mesh in one ArrayBuffer. Polyline k is points offsets[k] until
+    // offsets[k+1] of position; simpleNames[k] is its edge's name hash (outlinesOnly) or primitive name.
+    declare interface PackedEdgeBuffer {
+        position: Float32Array;
+        offsets: Uint32Array;
+        simpleNames: Uint32Array;
+    }
+
+    // The polylines of many curves, packed as in PackedEdgeBuffer; instance k has polylines items[k] until items[k+1].
+    declare interface PackedCurveBuffer extends PackedEdgeBuffer {
+        items: Uint32Array;
+    }
+
+    // Cross points of curves, one per row: curves pairs[2k] and pairs[2k+1] cross at params[2k] and params[2k+1] respectively.
+    declare interface PackedCrossPoints {
+        pairs: Uint32Array;
+        params: Float64Array;
+    }
+
+    // One byte per candidate solid, 1 if it intersects any of the solids.
+    declare type IntersectingCandidates = Uint8Array;
+
+    // Crease or silhouette edges of a mesh, chained across faces into polylines packed as in PackedEdgeBuffer.
+    declare interface FeatureEdgeBuffer {
+        position: Float32Array;
+        offsets: Uint32Array;
+    }
+
+    // Passed to long running operations; progress is called (on the main thread) with the amount of work done since the last call.
+    declare class ProgressIndicator {
+        constructor();
+        progress: (n: number) => void;
+    }
+
+    // A triangle BVH over grids (the faces of a solid, say); Raycast takes 6 floats (origin, direction) per ray and finds the
+    // nearest hit of each with near <= t < far: faces[k] is the index of the grid hit by ray k or -1, t[k] the distance in
+    // units of its direction.
+    declare class MeshBVH {
+        constructor(grids: Grid[], edges?: Float32Array[]);
+        readonly triangleCount: number;
+        Raycast(rays: Float32Array, near?: number, far?: number): { faces: Int32Array, t: Float32Array, point: Float32Array };
+        Boxcast(planes: Float32Array, contained: boolean): { faces: Int32Array, edges: Int32Array };
+    }
+
+    // The welded triangles of a mesh and the edges between them, so that only the facing test runs per view;
+    // Get finds the edges between a triangle facing the camera and one facing away.
+    declare class SilhouetteEdges {
+        constructor(mesh: Mesh, tolerance: number);
+        Get(camera: ViewCamera): FeatureEdgeBuffer;
+    }
+
+    // bounds has 10 floats per face, in the order of faces: the bounding box (min xyz, max xyz), then a cone
+    // containing all the face's normals (axis xyz, half-angle in radians; a zero axis and pi if unknown).
+    declare interface SolidTessellation {
+        faces: MeshBuffer[];
+        bounds: Float32Array;
+        edges: EdgeBuffer[];
+    }
+
+    // matrices has 16 floats (THREE.Matrix4.fromArray order) per copy the DuplicationValues would make
+    declare interface InstancedTessellation extends SolidTessellation {
+        matrices: Float32Array;
+    }
+
+    // Ids of the faces and edges the caller already has buffers for
+    declare interface KnownTessellation {
+        faces: BigInt64Array;
+        edges: BigInt64Array;
+    }
+
+    // faces/edges are only what had to be tessellated; faceIds/edgeIds are the ids of their originals (0n if
+    // changed). reusedFaces[k] is the index in the new solid of a face whose buffer is known under reusedFaceIds[k].
+    declare interface IncrementalTessellation extends SolidTessellation {
+        faceIds: BigInt64Array;
+        reusedFaces: Uint32Array;
+        reusedFaceIds: BigInt64Array;
+        removedFaceIds: BigInt64Array;
+        edgeIds: BigInt64Array;
+        reusedEdges: Uint32Array;
+        reusedEdgeIds: BigInt64Array;
+        removedEdgeIds: BigInt64Array;
+    }
+
+    // Receives the faces and edges that finished since the last batch, then done(), which says whether all of
+    // them succeeded. In a progressive tessellation the batches carry the fine buffers, by the same i as the coarse ones.
+    declare interface TessellationStream {
+        batch(faces: MeshBuffer[], edges: EdgeBuffer[]): void;
+        done(success: boolean): void;
+    }
+
+    // Everything in model units. fov is the vertical field of view in radians, or 0 for an orthographic
+    // camera whose visible height is height. Each face/edge is tessellated with the sag that keeps its error
+    // under pixelError pixels at its nearest depth, clamped to [minSag, maxSag].
+    declare interface ViewCamera {
+        eye: number[];
+        direction: number[];
+        fov: number;
+        height: number;
+        viewportHeight: number;
+        pixelError: number;
+        minSag: number;
+        maxSag: number;
+    }
+
+    // bytes and budget are approximate sizes of the cached grids
+    declare interface TessellationCacheStats {
+        hits: number;
+        misses: number;
+        evictions: number;
+        entries: number;
+        bytes: number;
+        budget: number;
+    }
+
     declare interface SolidDuplicateBuffer {
         originalFaceIds: BigInt64Array;
         copyFaceIds: BigInt64Array;
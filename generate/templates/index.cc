@@ -3,6 +3,9 @@
 <%_ for (c of classes) { _%>
 #include "./include/<%- c.cppClassName %>.h"
 <%_ } _%>
+#include "./include/ProgressIndicator.h"
+#include "./include/MeshBVH.h"
+#include "./include/MeshAddon.h"
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     Napi::ObjectReference* ref = new Napi::ObjectReference();
@@ -12,6 +15,9 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     <%_ for (c of classes) { _%>
     <%- c.cppClassName %>::Init(env, exports);
     <%_ } _%>
+    ProgressIndicator::Init(env, exports);
+    MeshBVH::Init(env, exports);
+    SilhouetteEdges::Init(env, exports);
 
     return exports;
 }
@@ -1,3 +1,4 @@
+import { ipcRenderer } from "electron";
 import * as visual from "../visual_model/VisualModel";
 import * as cmd from "../command/Command";
 import { ExportDialog } from './export/ExportDialog';
@@ -101,6 +102,7 @@ export class ExportCommand extends cmd.CommandLike {
         const factory = new ExportFactory(this.editor.db, this.editor.materials, this.editor.signals).resource(this);
         factory.solids = [...selected.solids];
         factory.filePath = this.filePath;
+        factory.progress = (written, total) => ipcRenderer.send('set-progress', total > 0 ? written / total : 1);
 
         const dialog = new ExportDialog(factory, this.editor.signals);
         await factory.update();
@@ -108,7 +110,11 @@ export class ExportCommand extends cmd.CommandLike {
             factory.update();
         }).resource(this);
 
-        await factory.commit();
+        try {
+            await factory.commit();
+        } finally {
+            ipcRenderer.send('set-progress', -1);
+        }
     }
 
     shouldAddToHistory(_: boolean) { return false }
@@ -1,12 +1,20 @@
 import * as THREE from "three";
+import { LineSegments2 } from "three/examples/jsm/lines/LineSegments2";
 import * as c3d from '../../kernel/kernel';
 import { derive } from "../../command/FactoryBuilder";
 import { GeometryFactory } from '../../command/GeometryFactory';
-import { point2point, unit, vec2vec } from "../../util/Conversion";
+import { TemporaryObject } from '../../editor/DatabaseLike';
+import { formNote, temporary_precision_distance } from "../../editor/GeometryDatabase";
+import { deunit, point2point, unit, vec2vec } from "../../util/Conversion";
 import * as visual from "../../visual_model/VisualModel";
+import { CurveBuilder, mergeBufferGeometries } from "../../visual_model/VisualModelBuilder";
 
 const maxItems = 1_000;
 
+// The same precision GeometryDatabase uses for temporary solids
+const [[previewPrecision,]] = temporary_precision_distance;
+const previewStepData = new c3d.StepData(c3d.StepType.SpaceStep, previewPrecision);
+
 export interface ArrayParams {
     dir1: THREE.Vector3;
     step1: number;
@@ -91,6 +99,72 @@ abstract class AbstractArrayFactory extends GeometryFactory implements ArrayPara
         return result;
     }
 
+    // One tessellation of the solid and, instead of a copy per item, the transform of each copy relative to the original
+    async instances(stepData: c3d.StepData, formNote: c3d.FormNote) {
+        const { params, _solid: { model: solid }, start } = this;
+        if (solid === undefined) throw new Error("invalid precondition");
+        const { faces, edges, matrices } = await solid.TessellateInstanced_async(params, stepData, formNote, true);
+        const count = Math.min(matrices.length / 16, maxItems);
+        const normalize = new THREE.Matrix4().fromArray(matrices, 16 * start).invert();
+        const transforms = [];
+        for (let k = start; k < count; k++) {
+            transforms.push(new THREE.Matrix4().fromArray(matrices, 16 * k).multiply(normalize));
+        }
+        return { faces, edges, transforms };
+    }
+
+    // NOTE: The preview of a solid array is one tessellation drawn as instances, rather than a tessellated copy per item.
+    // Line segments can't be instanced, so the edges of every copy are transformed into a single line geometry instead.
+    async doUpdate(abortEarly: () => boolean, options?: any): Promise<TemporaryObject[]> {
+        const { db, materials, _solid: { model: solid } } = this;
+        if (solid === undefined) return super.doUpdate(abortEarly, options);
+
+        const { faces, edges, transforms } = await this.instances(previewStepData, formNote);
+        if (abortEarly()) return [];
+
+        const original = this.solid;
+        const geometry = mergeBufferGeometries(faces);
+        const instanced = new THREE.InstancedMesh(geometry, materials.mesh(), transforms.length);
+        for (const [k, transform] of transforms.entries()) instanced.setMatrixAt(k, transform);
+
+        const polylines = [];
+        for (const transform of transforms) {
+            for (const { position } of edges) {
+                const attribute = new THREE.BufferAttribute(position.slice(), 3).applyMatrix4(transform);
+                polylines.push(attribute.array as Float32Array);
+            }
+        }
+        const { geometry: edgeGeometry } = CurveBuilder.mergePositions(polylines);
+        const outlines = new LineSegments2(edgeGeometry, materials.line());
+
+        const group = new THREE.Group();
+        group.add(instanced, outlines);
+        group.scale.setScalar(deunit(1));
+        group.visible = false;
+        db.temporaryObjects.add(group);
+        const temp: TemporaryObject = {
+            underlying: group,
+            show() {
+                group.visible = true;
+                original.visible = false;
+            },
+            hide() {
+                group.visible = false;
+                original.visible = true;
+            },
+            cancel() {
+                geometry.dispose();
+                edgeGeometry.dispose();
+                instanced.dispose();
+                db.temporaryObjects.remove(group);
+                original.visible = true;
+            }
+        };
+
+        this.cleanupTemps();
+        return this.temps = this.showTemps([temp]);
+    }
+
     get originalItem() {
         return this.object;
     }
@@ -37,26 +37,11 @@ export abstract class PossiblyBooleanFactory<GF extends GeometryFactory> extends
             isOverlapping = false;
             isSurface = false;
         } else {
-            const possible = [];
-            for (const phantom of phantoms) {
-                const cube1 = phantom.GetCube();
-                for (const model of this._targets.models) {
-                    const cube2 = model.GetCube();
-                    if (cube1.Intersect(cube2)) {
-                        possible.push({ phantom, model });
-                    }
-                }
-            }
-            if (possible.length === 0) {
-                isOverlapping = false;
-                isSurface = false;
-            } else {
-                const names = new c3d.SNameMaker(0, c3d.ESides.SideNone, 0);
-                const promises = possible.map(({ phantom, model }) => c3d.Action.IsSolidsIntersectionFast_async(phantom, model, names));
-                const intersections = await Promise.all(promises);
-                isOverlapping = intersections.some(x => x);
-                isSurface = false;
-            }
+            // NOTE: bounding boxes cull the far away models natively; only the overlapping pairs are checked exactly, in parallel
+            const names = new c3d.SNameMaker(0, c3d.ESides.SideNone, 0);
+            const intersecting = await c3d.SolidIntersection.Intersect_async(phantoms, this._targets.models, names);
+            isOverlapping = intersecting.some(x => x === 1);
+            isSurface = false;
         }
         return { phantoms, isOverlapping, isSurface };
     }
@@ -1,12 +1,11 @@
-import * as fs from 'fs';
+import * as path from 'path';
 import * as THREE from 'three';
-import { OBJExporter } from 'three/examples/jsm/exporters/OBJExporter.js';
-import * as BufferGeometryUtils from 'three/examples/jsm/utils/BufferGeometryUtils.js';
 import * as c3d from '../../kernel/kernel';
 import * as visual from '../../visual_model/VisualModel';
 import { deunit } from '../../util/Conversion';
 import { GeometryFactory } from '../../command/GeometryFactory';
 import { TemporaryObject } from '../../editor/DatabaseLike';
+import { packedBufferGeometry } from '../../visual_model/VisualModelBuilder';
 
 export interface ExportParams {
     sag: number;
@@ -33,6 +32,9 @@ export class ExportFactory extends GeometryFactory {
     maxCount = 50;
     stepType = c3d.StepType.SpaceStep;
 
+    // Called as the file is written, with the triangles written so far and the total
+    progress?: (written: number, total: number) => void;
+
     private readonly formNote = new c3d.FormNote(false, true, false, false, true);
 
     async doUpdate(): Promise<TemporaryObject[]> {
@@ -70,60 +72,60 @@ export class ExportFactory extends GeometryFactory {
         return this.temps = this.showTemps(temps);
     }
 
-    private async calc(): Promise<THREE.Object3D[]> {
-        const { db, models, formNote, stepType, sag, angle, length, maxCount } = this;
-
+    private get stepData() {
+        const { stepType, sag, angle, length, maxCount } = this;
         const stepData = new c3d.StepData();
         stepData.Init(stepType, sag, angle, length, maxCount);
         stepData.SetStepType(c3d.StepType.ParamStep, true);
         stepData.SetStepType(c3d.StepType.MetricStep, true);
         stepData.SetStepType(c3d.StepType.DeviationStep, true);
+        return stepData;
+    }
+
+    private async calc(): Promise<THREE.Object3D[]> {
+        const { models, formNote, stepData } = this;
 
         const objects = [];
         for (const model of models) {
             const mesh = await model.CalculateMesh_async(stepData, formNote);
-            const buffers = mesh.GetBuffers();
+            const geometry = packedBufferGeometry(mesh.GetPackedBuffers());
             const object = new THREE.Group();
             object.scale.setScalar(deunit(1));
-            for (const buffer of buffers) {
-                const geometry = new THREE.BufferGeometry();
-                geometry.setIndex(new THREE.BufferAttribute(buffer.index, 1));
-                geometry.setAttribute('position', new THREE.BufferAttribute(buffer.position, 3));
-                geometry.setAttribute('normal', new THREE.BufferAttribute(buffer.normal, 3));
-                const wireframe = new THREE.WireframeGeometry(geometry);
-                const line = new THREE.LineSegments(wireframe);
-                line.userData.geometry = geometry;
-                object.add(line);
-            };
+            const wireframe = new THREE.WireframeGeometry(geometry);
+            const line = new THREE.LineSegments(wireframe);
+            line.userData.geometry = geometry;
+            object.add(line);
             objects.push(object)
         }
 
         return objects;
     }
 
+    // The meshes are written to the file natively, off the main thread, without building any geometry in JS.
     async doCommit() {
-        const { filePath } = this;
-        const objects = await this.calc();
+        const { filePath, models, formNote, stepData, progress } = this;
 
-        const scene = new THREE.Scene();
-        for (const object of objects) {
-            const geometries: THREE.BufferGeometry[] = [];
-            for (const child of object.children) {
-                const line = child as THREE.LineSegments;
-                const geometry = line.userData.geometry as THREE.BufferGeometry;
-                if (geometry.attributes.position.array.length === 0) continue;
-                geometries.push(geometry);
-            }
-            const merged = BufferGeometryUtils.mergeBufferGeometries(geometries);
-            merged.scale(deunit(1), deunit(1), deunit(1));
-            const mesh = new THREE.Mesh(merged);
-            mesh.scale.setScalar(deunit(1));
-            scene.add(mesh);
+        const meshes = await Promise.all(models.map(model => model.CalculateMesh_async(stepData, formNote)));
+
+        // NOTE: The writer releases the indicator's callback once the file is written (or fails)
+        const indicator = new c3d.ProgressIndicator();
+        if (progress !== undefined) {
+            const total = c3d.MeshExport.CountTriangles(meshes);
+            let written = 0;
+            indicator.progress = (n: number) => progress(written += n, total);
         }
 
-        const exporter = new OBJExporter();
-        const string = exporter.parse(scene);
-        await fs.promises.writeFile(filePath, string);
+        const scale = deunit(1);
+        switch (path.extname(filePath).toLowerCase()) {
+            case '.stl':
+                await c3d.MeshExport.WriteStl_async(meshes, filePath, scale, indicator);
+                break;
+            case '.glb':
+                await c3d.MeshExport.WriteGlb_async(meshes, filePath, scale, indicator);
+                break;
+            default:
+                await c3d.MeshExport.WriteObj_async(meshes, filePath, scale, indicator);
+        }
 
         for (const temp of this.temps) temp.cancel();
 
@@ -10,13 +10,13 @@ import { Agent, ControlPointData, DatabaseLike, MaterialOverride, TemporaryObjec
 import { EditorSignals } from './EditorSignals';
 import { GeometryMemento, MementoOriginator } from './History';
 import MaterialDatabase from './MaterialDatabase';
-import { MeshCreator } from './MeshCreator';
+import { MeshCreator, MeshLike } from './MeshCreator';
 import { SolidCopier, SolidCopierPool } from './SolidCopier';
 
 const mesh_precision_distance: [number, number][] = [[unit(0.05), 1000], [unit(0.0009), 1]];
 const other_precision_distance: [number, number][] = [[unit(0.0005), 1]];
-const temporary_precision_distance: [number, number][] = [[unit(0.003), 1]];
-const formNote = new c3d.FormNote(true, true, false, false, false);
+export const temporary_precision_distance: [number, number][] = [[unit(0.003), 1]];
+export const formNote = new c3d.FormNote(true, true, false, false, false);
 
 type Builder = build.SpaceInstanceBuilder<visual.Curve3D | visual.Surface> | build.PlaneInstanceBuilder<visual.Region> | build.SolidBuilder;
 
@@ -50,13 +50,15 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
     async addItem(model: c3d.PlaneInstance, agent?: Agent, name?: c3d.SimpleName): Promise<visual.PlaneInstance<visual.Region>>;
     async addItem(model: c3d.Item, agent?: Agent, name?: c3d.SimpleName): Promise<visual.Item>;
     async addItem(model: c3d.Item, agent: Agent = 'user', name?: c3d.SimpleName): Promise<visual.Item> {
-        return this.queue.enqueue(async () => {
-            const result = await this.insertItem(model, agent, name);
-            this.version2id.set(result.simpleName, result.simpleName);
-            this.id2version.set(result.simpleName, result.simpleName);
-            this.signals.objectAdded.dispatch([result, agent]);
-            return result;
-        });
+        return this.queue.enqueue(() => this._addItem(model, agent, name));
+    }
+
+    private async _addItem(model: c3d.Item, agent: Agent, name?: c3d.SimpleName, tessellated?: MeshLike): Promise<visual.Item> {
+        const result = await this.insertItem(model, agent, name, tessellated);
+        this.version2id.set(result.simpleName, result.simpleName);
+        this.id2version.set(result.simpleName, result.simpleName);
+        this.signals.objectAdded.dispatch([result, agent]);
+        return result;
     }
 
     async replaceItem(from: visual.Solid, model: c3d.Solid, agent?: Agent): Promise<visual.Solid>;
@@ -93,11 +95,72 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
         });
     }
 
-    private async insertItem(model: c3d.Item, agent: Agent, name?: c3d.SimpleName): Promise<visual.Item> {
+    // All regions on a placement are triangulated together, in one native call, rather than one CreateMesh each
+    async addRegions(regions: c3d.Region[], placement: c3d.Placement3D, agent: Agent = 'user'): Promise<visual.PlaneInstance<visual.Region>[]> {
+        return this.queue.enqueue(async () => {
+            const [[precision,]] = other_precision_distance;
+            const stepData = new c3d.StepData(c3d.StepType.SpaceStep, precision);
+            const stats = Measure.get("create-mesh");
+            stats.begin();
+            const { index, position, normal, groups } = await c3d.RegionTessellation.Tessellate_async(regions, placement, stepData, formNote);
+            stats.end();
+
+            const result = [];
+            for (const [k, region] of regions.entries()) {
+                const [indexStart, indexCount, pointStart, pointCount] = groups.subarray(4 * k, 4 * k + 4);
+                const face = {
+                    index: index.subarray(indexStart, indexStart + indexCount),
+                    position: position.subarray(3 * pointStart, 3 * (pointStart + pointCount)),
+                    normal: normal.subarray(3 * pointStart, 3 * (pointStart + pointCount)),
+                } as c3d.MeshBuffer;
+                const view = await this._addItem(new c3d.PlaneInstance(region, placement), agent, undefined, { faces: [face], edges: [] });
+                result.push(view as visual.PlaneInstance<visual.Region>);
+            }
+            return result;
+        });
+    }
+
+    // Likewise, the polylines of many curves are sampled together. A curve that can't be added doesn't stop the rest:
+    // its view is undefined and its error is returned with the others.
+    private async addCurves(instances: c3d.SpaceInstance[], names: (c3d.SimpleName | undefined)[], agent: Agent = 'user'): Promise<{ views: (visual.SpaceInstance<visual.Curve3D> | undefined)[], errors: unknown[] }> {
+        return this.queue.enqueue(async () => {
+            const [[precision,]] = other_precision_distance;
+            const stepData = new c3d.StepData(c3d.StepType.SpaceStep, precision);
+            const stats = Measure.get("create-mesh");
+            stats.begin();
+            const { position, offsets, items } = await c3d.CurveTessellation.Tessellate_async(instances, stepData, formNote);
+            stats.end();
+
+            const views = [], errors = [];
+            for (const [k, instance] of instances.entries()) {
+                const edges = [];
+                for (let j = items[k]; j < items[k + 1]; j++) {
+                    edges.push({ position: position.subarray(3 * offsets[j], 3 * offsets[j + 1]) } as c3d.EdgeBuffer);
+                }
+                try {
+                    const view = await this._addItem(instance, agent, names[k], { faces: [], edges });
+                    views.push(view as visual.SpaceInstance<visual.Curve3D>);
+                } catch (e) {
+                    views.push(undefined);
+                    errors.push(e);
+                }
+            }
+            return { views, errors };
+        });
+    }
+
+    private async insertItem(model: c3d.Item, agent: Agent, name?: c3d.SimpleName, tessellated?: MeshLike): Promise<visual.Item> {
         if (name === undefined) name = this.positiveCounter++;
         else (this.positiveCounter = Math.max(this.positiveCounter, name + 1));
 
-        const builder = await this.meshes(model, name, this.precisionAndDistanceFor(model), true); // TODO: it would be nice to move this out of the queue but tests fail
+        let builder;
+        if (tessellated === undefined) {
+            builder = await this.meshes(model, name, this.precisionAndDistanceFor(model), true); // TODO: it would be nice to move this out of the queue but tests fail
+        } else {
+            const [[, distance]] = this.precisionAndDistanceFor(model);
+            builder = this.builderFor(model);
+            this.mesh2builder(builder, model, tessellated, name, distance);
+        }
         const view = builder.build(name, this.topologyModel, this.controlPointModel);
         view.userData.simpleName = name;
 
@@ -140,12 +203,14 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
     private async _addTemporaryItem(model: c3d.Item, ancestor?: visual.Item, materials?: MaterialOverride, into = this.temporaryObjects): Promise<TemporaryObject> {
         const { signals } = this;
         const tempId = this.negativeCounter--;
+        const produced: MeshLike[] = [];
         const builder = await this.meshes(
             model,
             tempId,
             this.precisionAndDistanceFor(model, 'temporary'),
             false,
-            materials);
+            materials,
+            produced);
         const view = builder.build(tempId);
         into.add(view);
 
@@ -163,6 +228,9 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
             cancel() {
                 view.dispose();
                 into.remove(view);
+                // NOTE: temporaries are remeshed on every update; the grids are reused once nothing else refers to them.
+                // Those a mesh creator's cache still holds (say, faces an operation left unchanged) are left alone.
+                c3d.MeshBufferPool.Recycle(produced.flatMap(({ faces, shared }) => shared === undefined ? faces : faces.filter(face => !shared.has(face.grid))));
                 if (ancestor !== undefined) ancestor.visible = true;
                 signals.objectRemoved.dispatch([view, 'automatic']); // TODO: investigate if this is necessary
             }
@@ -261,38 +329,57 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
         return [...this.geometryModel.values()];
     }
 
-    private async meshes(obj: c3d.Item, id: c3d.SimpleName, precision_distance: [number, number][], includeMetadata: boolean, materials?: MaterialOverride): Promise<build.Builder<visual.SpaceInstance<visual.Curve3D | visual.Surface> | visual.Solid | visual.PlaneInstance<visual.Region>>> {
-        let builder;
+    private builderFor(obj: c3d.Item): Builder {
         switch (obj.IsA()) {
             case c3d.SpaceType.SpaceInstance:
-                builder = new build.SpaceInstanceBuilder<visual.Curve3D | visual.Surface>();
-                break;
+                return new build.SpaceInstanceBuilder<visual.Curve3D | visual.Surface>();
             case c3d.SpaceType.PlaneInstance:
-                builder = new build.PlaneInstanceBuilder<visual.Region>();
-                break;
+                return new build.PlaneInstanceBuilder<visual.Region>();
             case c3d.SpaceType.Solid:
-                builder = new build.SolidBuilder();
-                break;
+                return new build.SolidBuilder();
             default:
                 throw new Error(`type ${c3d.SpaceType[obj.IsA()]} not yet supported`);
         }
+    }
+
+    private async meshes(obj: c3d.Item, id: c3d.SimpleName, precision_distance: [number, number][], includeMetadata: boolean, materials?: MaterialOverride, produced?: MeshLike[]): Promise<build.Builder<visual.SpaceInstance<visual.Curve3D | visual.Surface> | visual.Solid | visual.PlaneInstance<visual.Region>>> {
+        const builder = this.builderFor(obj);
+
+        const { meshCreator } = this;
+        if (obj.IsA() === c3d.SpaceType.Solid && precision_distance.length > 1 && meshCreator.createLevels !== undefined) {
+            // NOTE: all levels of detail are tessellated together, in one native pass
+            const stepDatas = precision_distance.map(([precision,]) => new c3d.StepData(c3d.StepType.SpaceStep, precision));
+            const stats = Measure.get("create-mesh");
+            stats.begin();
+            const items = await meshCreator.createLevels(obj, stepDatas, formNote, true, includeMetadata);
+            stats.end();
+            produced?.push(...items);
+            for (const [i, item] of items.entries()) {
+                this.mesh2builder(builder, obj, item, id, precision_distance[i][1], materials);
+            }
+            return builder;
+        }
 
         const promises = [];
         for (const [precision, distance] of precision_distance) {
-            promises.push(this.object2mesh(builder, obj, id, precision, distance, includeMetadata, materials));
+            promises.push(this.object2mesh(builder, obj, id, precision, distance, includeMetadata, materials, produced));
         }
         await Promise.all(promises);
 
         return builder;
     }
 
-    private async object2mesh(builder: Builder, obj: c3d.Item, id: c3d.SimpleName, sag: number, distance: number, includeMetadata: boolean, materials?: MaterialOverride): Promise<void> {
+    private async object2mesh(builder: Builder, obj: c3d.Item, id: c3d.SimpleName, sag: number, distance: number, includeMetadata: boolean, materials?: MaterialOverride, produced?: MeshLike[]): Promise<void> {
         const stepData = new c3d.StepData(c3d.StepType.SpaceStep, sag);
         const stats = Measure.get("create-mesh");
         stats.begin();
         const item = await this.meshCreator.create(obj, stepData, formNote, obj.IsA() === c3d.SpaceType.Solid, includeMetadata);
         stats.end();
+        produced?.push(item);
+        this.mesh2builder(builder, obj, item, id, distance, materials);
+    }
 
+    private mesh2builder(builder: Builder, obj: c3d.Item, item: MeshLike, id: c3d.SimpleName, distance: number, materials?: MaterialOverride) {
         switch (obj.IsA()) {
             case c3d.SpaceType.SpaceInstance: {
                 const instance = obj as c3d.SpaceInstance;
@@ -437,8 +524,28 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
         return this.load(everything);
     }
 
+    // The face grids of every solid at the precisions used for the viewport, so that a saved file reopens without re-meshing.
+    // NOTE: grids the tessellation cache already has from displaying the solids are copied; any others are meshed here
+    async serializeTessellation(): Promise<Buffer> {
+        const solids = [];
+        for (const { model } of this.geometryModel.values()) {
+            if (model.IsA() === c3d.SpaceType.Solid) solids.push(model as c3d.Solid);
+        }
+        const stepDatas = mesh_precision_distance.map(([precision,]) => new c3d.StepData(c3d.StepType.SpaceStep, precision));
+        return c3d.TessellationCache.Save_async(solids, stepDatas, formNote);
+    }
+
+    // NOTE: grids are only set aside here; a solid uses them if, when loaded, its content is exactly what was saved
+    async deserializeTessellation(data: Buffer): Promise<void> {
+        await c3d.TessellationCache.Load_async(data);
+    }
+
     async load(model: c3d.Model, preserveNames = false): Promise<visual.Item[]> {
-        const promises: Promise<visual.Item>[] = [];
+        const promises: Promise<void>[] = [];
+        // NOTE: names and places in the result are taken in traversal order, even though the curves are added last
+        const result: visual.Item[] = [];
+        let slot = 0;
+        const curves: c3d.SpaceInstance[] = [], curveNames: c3d.SimpleName[] = [], curveSlots: number[] = [];
         const loadItems = (stack: c3d.Item[]) => {
             while (stack.length > 0) {
                 const item = stack.shift()!;
@@ -448,14 +555,32 @@ export class GeometryDatabase implements DatabaseLike, MementoOriginator<Geometr
                 } else if (cast instanceof c3d.Instance) {
                     stack.push(cast.GetItem()!);
                 } else {
-                    const name = preserveNames ? item.GetItemName() : undefined;
-                    promises.push(this.addItem(cast, 'user', name));
+                    const name = preserveNames ? item.GetItemName() : this.positiveCounter++;
+                    const k = slot++;
+                    if (cast instanceof c3d.SpaceInstance && cast.GetSpaceItem()?.Family() === c3d.SpaceType.Curve3D) {
+                        curves.push(cast);
+                        curveNames.push(name);
+                        curveSlots.push(k);
+                    } else {
+                        promises.push(this.addItem(cast, 'user', name).then(view => { result[k] = view }));
+                    }
                 }
             }
         }
 
         loadItems(model.GetItems());
-        return Promise.all(promises);
+        // NOTE: sketches can have thousands of curves; they are all sampled in one native call
+        const errors: unknown[] = [];
+        if (curves.length > 0) {
+            promises.push(this.addCurves(curves, curveNames).then(({ views, errors: failed }) => {
+                for (const [i, view] of views.entries()) if (view !== undefined) result[curveSlots[i]] = view;
+                errors.push(...failed);
+            }));
+        }
+        await Promise.all(promises);
+        // As when each item is added on its own, a bad curve fails the load, but only once everything else is in
+        if (errors.length > 0) throw errors[0];
+        return result;
     }
 
     validate() {
@@ -28,8 +28,9 @@ export class ImporterExporter {
 
     async open(filePath: string) {
         const data = await fs.promises.readFile(filePath);
-        const { json, c3d } = Chunkifier.load(data);
+        const { json, c3d, tessellation } = Chunkifier.load(data);
         this.originator.clear();
+        if (tessellation !== undefined) await this.db.deserializeTessellation(tessellation);
         await PlasticityDocument.load(json, c3d, this.originator);
         this.originator.debug();
         this.originator.validate();
@@ -65,7 +66,8 @@ export class ImporterExporter {
         if (/\.plasticity$/.test(filePath!)) {
             const document = new PlasticityDocument(this.originator);
             const { json, c3d } = await document.serialize(filePath);
-            const chunkifier = new Chunkifier('plasticity', 1, json, c3d);
+            const tessellation = await this.db.serializeTessellation();
+            const chunkifier = new Chunkifier('plasticity', 1, json, c3d, tessellation);
             const buffer = chunkifier.serialize();
             return fs.promises.writeFile(filePath, buffer);
         } else if (/\.c3d$/.test(filePath!)) {
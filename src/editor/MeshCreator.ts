@@ -5,10 +5,14 @@ import { SolidCopier } from './SolidCopier';
 export interface MeshLike {
     faces: c3d.MeshBuffer[];
     edges: c3d.EdgeBuffer[];
+    // Grids of faces that a cache still holds and may hand out again, so they mustn't be recycled with the rest
+    shared?: ReadonlySet<c3d.Grid>;
 }
 
 export interface MeshCreator {
     create(obj: c3d.Item, stepData: c3d.StepData, formNote: c3d.FormNote, outlinesOnly: boolean, includeMetadata: boolean): Promise<MeshLike>;
+    // One MeshLike per stepData, for creators that can do all levels of detail at once
+    createLevels?(obj: c3d.Item, stepDatas: c3d.StepData[], formNote: c3d.FormNote, outlinesOnly: boolean, includeMetadata: boolean): Promise<MeshLike[]>;
 }
 
 export interface CachingMeshCreator extends MeshCreator {
@@ -48,55 +52,16 @@ export class ParallelMeshCreator implements MeshCreator {
     async create(obj: c3d.Item, stepData: c3d.StepData, formNote: c3d.FormNote, outlinesOnly: boolean, includeMetadata: boolean): Promise<MeshLike> {
         if (obj.IsA() !== c3d.SpaceType.Solid) return this.fallback.create(obj, stepData, formNote, outlinesOnly, includeMetadata);
         const solid = obj as c3d.Solid;
-        const shell = solid.GetShell()!;
-
-        c3d.Mutex.EnterParallelRegion();
-
-        const facePromises: Promise<c3d.MeshBuffer>[] = [];
-        const mesh = new c3d.Mesh(false);
-        const faces = shell.GetFaces();
-        for (const [i, face] of faces.entries()) {
-            const grid = mesh.AddGrid()!;
-            face.AttributesConvert(grid);
-            grid.SetItem(face);
-            const simpleName = face.GetNameHash();
-            grid.SetPrimitiveName(simpleName);
-            grid.SetPrimitiveType(c3d.RefType.TopItem);
-            grid.SetStepData(stepData);
-            // NOTE: there is a significant performance penalty for using calculateFace, so it is inlined here
-            const buf = c3d.TriFace.CalculateGrid_async(face, stepData, grid, false, formNote.Quad(), formNote.Fair()).then(() => {
-                const { index, position, normal } = grid.GetBuffers();
-                return { index, position, normal, grid, model: face, style: face.GetStyle(), simpleName, i };
-            })
-            facePromises.push(buf);
-        }
-
-        const edgePromises: Promise<c3d.Mesh>[] = [];
-        const edges = solid.GetEdges();
-        for (const edge of edges) {
-            edgePromises.push(edge.CalculateMesh_async(stepData, formNote));
-        }
-
-        const edgeResult_ = await Promise.all(edgePromises);
-        const edgeResult = [];
-        for (const [i, mesh] of edgeResult_.entries()) {
-            // NOTE: there is a significant performance penalty for using calculateEdges, so it is inlined here
-            const edge = edges[i];
-            const outlines = mesh.GetEdges(outlinesOnly);
-            if (outlines.length === 0) continue;
-            const polygon = outlines[0];
-            polygon.i = i;
-            polygon.model = edge;
-            edgeResult.push(polygon);
-        }
-
-        const faceResult = await Promise.all(facePromises);
-        c3d.Mutex.ExitParallelRegion();
+        // NOTE: faces (largest first) and edges are tessellated on native threads in a single call,
+        // which avoids paying for a worker and a promise per face and per edge.
+        // Only committed items (the ones with metadata) go into the native tessellation cache.
+        return solid.TessellateParallel_async(stepData, formNote, outlinesOnly, includeMetadata);
+    }
 
-        return {
-            faces: faceResult,
-            edges: edgeResult
-        };
+    async createLevels(obj: c3d.Item, stepDatas: c3d.StepData[], formNote: c3d.FormNote, outlinesOnly: boolean, includeMetadata: boolean): Promise<MeshLike[]> {
+        if (obj.IsA() !== c3d.SpaceType.Solid) return Promise.all(stepDatas.map(stepData => this.fallback.create(obj, stepData, formNote, outlinesOnly, includeMetadata)));
+        const solid = obj as c3d.Solid;
+        return solid.TessellateLevels_async(stepDatas, formNote, outlinesOnly, includeMetadata);
     }
 
     async calculateFace(mesh: c3d.Mesh, face: c3d.Face, stepData: c3d.StepData, formNote: c3d.FormNote, i: number): Promise<c3d.MeshBuffer> {
@@ -152,6 +117,12 @@ export class DoCacheMeshCreator implements CachingMeshCreator {
         const creator = this.cache ?? this.fallback;
         return creator.create(obj, stepData, formNote, outlinesOnly, includeMetadata);
     }
+
+    createLevels(obj: c3d.Item, stepDatas: c3d.StepData[], formNote: c3d.FormNote, outlinesOnly: boolean, includeMetadata: boolean): Promise<MeshLike[]> {
+        const cache = this.cache;
+        if (cache === undefined) return this.fallback.createLevels(obj, stepDatas, formNote, outlinesOnly, includeMetadata);
+        return Promise.all(stepDatas.map(stepData => cache.create(obj, stepData, formNote, outlinesOnly, includeMetadata)));
+    }
 }
 
 export class ObjectCacheMeshCreator implements MeshCreator {
@@ -181,87 +152,90 @@ export class ObjectCacheMeshCreator implements MeshCreator {
     }
 }
 
+// The id TessellateIncremental reports for faces and edges that changed and so can't be cached
+const noOriginal = BigInt(0);
+
 export class FaceCacheMeshCreator implements MeshCreator {
     // TODO: really should use FormAndPrecisionKey somehow
     private readonly fallback = new ParallelMeshCreator();
-    private readonly faceCache = new Map<bigint, [c3d.MeshBuffer, c3d.EdgeBuffer[]]>();
+    // Buffers of the faces and edges of the latest solid made from each pool original, by their ids
+    private readonly faceCache = new Map<bigint, c3d.MeshBuffer>();
+    private readonly edgeCache = new Map<bigint, c3d.EdgeBuffer>();
+    // Which original each cached id came from; a token shared by all the ids of one original's faces and edges
+    private readonly lineages = new Map<bigint, object>();
+    private inFlight = 0;
 
     constructor(private readonly underlying: ParallelMeshCreator, private readonly copier: SolidCopier) { }
 
     async create(obj: c3d.Item, stepData: c3d.StepData, formNote: c3d.FormNote, outlinesOnly: boolean, includeMetadata: boolean): Promise<MeshLike> {
         if (obj.IsA() !== c3d.SpaceType.Solid || includeMetadata) return this.fallback.create(obj, stepData, formNote, outlinesOnly, includeMetadata);
-        const { faceCache, copier: { faces: history }, underlying } = this;
+        const { faceCache, edgeCache, lineages, copier: { histories } } = this;
 
         const solid = obj as c3d.Solid;
-        const shell = solid.GetShell()!;
-
-        c3d.Mutex.EnterParallelRegion();
-
-        const facePromises: Promise<c3d.MeshBuffer>[] = [];
-        const edgePromises: Promise<c3d.EdgeBuffer[]>[] = [];
-        const mesh = new c3d.Mesh(false);
-        const cachedFaces = [];
-        const cachedEdges = [];
-        const faces = shell.GetFaces();
-        const seenEdges = new Set<bigint>();
-        for (const [i, face] of faces.entries()) {
-            const id = history.get(face.Id());
-            const isCacheable = !face.GetOwnChanged() && id !== undefined;
-            const existingGrid = isCacheable ? faceCache.get(id) : undefined;
-            if (isCacheable && existingGrid !== undefined) {
-                const [face, edges] = existingGrid;
-                cachedFaces.push(face);
-                cachedEdges.push(...edges);
-            } else {
-                const facePromise = underlying.calculateFace(mesh, face, stepData, formNote, i);
-                const edges = face.GetEdges();
-                const edgeMeshPromises = [];
-                for (const edge of edges) {
-                    const id = edge.Id();
-                    const unseen = !seenEdges.has(id);
-                    if (unseen) {
-                        seenEdges.add(id);
-                        edgeMeshPromises.push(edge.CalculateMesh_async(stepData, formNote));
-                    }
-                }
-                const edgeBufferPromises = this.cacheFace(id, isCacheable, facePromise, edgeMeshPromises, outlinesOnly);
-                facePromises.push(facePromise);
-                edgePromises.push(edgeBufferPromises);
-            }
+        // NOTE: The caches only hold the previous solid of each original, so this is as large as the solids being edited.
+        const known = { faces: new BigInt64Array(faceCache.keys()), edges: new BigInt64Array(edgeCache.keys()) };
+        // NOTE: Only faces and edges that changed (or that we have nothing cached for) are tessellated natively.
+        let delta: c3d.IncrementalTessellation;
+        this.inFlight++;
+        try {
+            delta = await solid.TessellateIncremental_async(histories, known, stepData, formNote, outlinesOnly);
+        } finally {
+            this.inFlight--;
+        }
+        const { faces, faceIds, reusedFaces, reusedFaceIds, removedFaceIds, edges, edgeIds, reusedEdges, reusedEdgeIds, removedEdgeIds } = delta;
+
+        const allFaces = faces.slice();
+        const shared = new Set<c3d.Grid>();
+        for (const [k, i] of reusedFaces.entries()) {
+            const cached = faceCache.get(reusedFaceIds[k])!;
+            allFaces.push({ ...cached, i, model: solid.GetFace(i)! });
+            shared.add(cached.grid);
+        }
+        const allEdges = edges.slice();
+        for (const [k, i] of reusedEdges.entries()) {
+            const cached = edgeCache.get(reusedEdgeIds[k])!;
+            allEdges.push({ ...cached, i, model: solid.GetEdge(i)! });
         }
 
-        const edgeBufferss = await Promise.all(edgePromises);
-        const edgeBuffers = [];
-        for (const edge of edgeBufferss) {
-            edgeBuffers.push(...edge);
+        // The solid was made from the same original as whatever it shares an id with
+        const ids = [...reusedFaceIds, ...reusedEdgeIds, ...faceIds, ...edgeIds].filter(id => id !== noOriginal);
+        let lineage: object | undefined;
+        for (const id of ids) if ((lineage = lineages.get(id)) !== undefined) break;
+        lineage ??= {};
+
+        // Known ids of the same original that this solid didn't reuse are gone for good, unless another create
+        // (still awaiting its own delta) might yet reuse them; then the next create drops them instead.
+        if (this.inFlight === 0) {
+            for (const id of removedFaceIds) {
+                if (lineages.get(id) !== lineage) continue;
+                faceCache.delete(id);
+                lineages.delete(id);
+            }
+            for (const id of removedEdgeIds) {
+                if (lineages.get(id) !== lineage) continue;
+                edgeCache.delete(id);
+                lineages.delete(id);
+            }
         }
-        const allEdges = cachedEdges.concat(edgeBuffers);
 
-        const allFaces = cachedFaces.concat(await Promise.all(facePromises));
-        c3d.Mutex.ExitParallelRegion();
+        for (const [k, face] of faces.entries()) {
+            const id = faceIds[k];
+            if (id === noOriginal) continue;
+            faceCache.set(id, face);
+            shared.add(face.grid);
+        }
+        for (const [k, edge] of edges.entries()) {
+            const id = edgeIds[k];
+            if (id !== noOriginal) edgeCache.set(id, edge);
+        }
+        for (const id of ids) lineages.set(id, lineage);
 
         return {
             faces: allFaces,
             edges: allEdges,
+            shared,
         };
     }
-
-    private async cacheFace(id: bigint | undefined, isCacheable: boolean, facePromise: Promise<c3d.MeshBuffer>, edgePromises: Promise<c3d.Mesh>[], outlinesOnly: boolean) {
-        const faceCache = this.faceCache;
-        const edges_ = await Promise.all(edgePromises);
-        const edgeResult = [];
-        for (const mesh of edges_) {
-            const outlines = mesh.GetEdges(outlinesOnly);
-            if (outlines.length === 0) continue;
-            const polygon = outlines[0];
-            edgeResult.push(polygon);
-        }
-        if (isCacheable) {
-            const faceResult = await facePromise;
-            faceCache.set(id!, [faceResult, edgeResult]);
-        }
-        return edgeResult;
-    }
 }
 
 type FormAndPrecisionKey = number;
@@ -1,21 +1,21 @@
 import c3d from '../../build/Release/c3d.node';
 
 export class SolidCopier {
-    private _faces?: Map<bigint, bigint> = undefined;
-    get faces(): ReadonlyMap<bigint, bigint> { return this._faces ?? new Map() }
+    private _histories?: c3d.SolidDuplicate[] = undefined;
+    get histories(): c3d.SolidDuplicate[] { return this._histories ?? [] }
 
     pool(solid: c3d.Solid, size: number) {
         const underlying = new c3d.SolidPool(solid);
-        return new SolidCopierPool(underlying, this._faces);
+        return new SolidCopierPool(underlying, this._histories);
     }
 
     async caching(f: () => Promise<void>) {
-        this._faces = new Map();
+        this._histories = [];
         try {
             const result = await f();
             return result;
         } finally {
-            this._faces = undefined;
+            this._histories = undefined;
         }
     }
 }
@@ -23,20 +23,15 @@ export class SolidCopier {
 const defaultPoolSize = 10;
 const refillAt = 5;
 export class SolidCopierPool {
-    constructor(private readonly pool: c3d.SolidPool, private readonly faceHistory: Map<bigint, bigint> | undefined) {
+    constructor(private readonly pool: c3d.SolidPool, private readonly histories: c3d.SolidDuplicate[] | undefined) {
         this.pool.Alloc_async(defaultPoolSize);
     }
 
     async Pop(): Promise<c3d.Solid> {
         const result = await this.pool.Pop_async();
         if (this.pool.Count() == refillAt) this.pool.Alloc_async(defaultPoolSize);
-        const { faceHistory } = this;
-        if (faceHistory !== undefined) {
-            const { originalFaceIds, copyFaceIds } = result.GetBuffers();
-            for (let i = 0, n = originalFaceIds.length; i < n; i++) {
-                faceHistory.set(copyFaceIds[i], originalFaceIds[i]);
-            }
-        }
+        // The face and edge history stays native; see Solid.TessellateIncremental
+        this.histories?.push(result);
         return result.GetCopy()!;
     }
 }
\ No newline at end of file
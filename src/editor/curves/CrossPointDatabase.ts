@@ -3,6 +3,59 @@ import { point2point } from '../../util/Conversion';
 import { CrossPointMemento, MementoOriginator } from '../History';
 import { Transaction } from './ContourManager';
 
+const mEps = 10e-3;
+
+// A curve and its bounding box (min xyz, max xyz), grown by mEps
+type BoxedCurve = { id: c3d.SimpleName, curve: c3d.Curve3D, box: readonly number[] };
+
+function boxed(id: c3d.SimpleName, curve: c3d.Curve3D): BoxedCurve {
+    const cube = new c3d.Cube();
+    curve.AddYourGabaritTo(cube);
+    const { pmin, pmax } = cube;
+    return { id, curve, box: [pmin.x - mEps, pmin.y - mEps, pmin.z - mEps, pmax.x + mEps, pmax.y + mEps, pmax.z + mEps] };
+}
+
+// The curves sorted by the lower x of their boxes. It is kept between calls, so that only the curves whose boxes overlap
+// a new curve's are handed to the native intersection. It is never changed in place, so nested databases can share it.
+class CurveIndex {
+    constructor(private readonly sorted: readonly BoxedCurve[] = []) { }
+
+    overlapping(box: readonly number[]): BoxedCurve[] {
+        const { sorted } = this;
+        let lo = 0, hi = sorted.length;
+        while (lo < hi) {
+            const mid = (lo + hi) >> 1;
+            if (sorted[mid].box[0] <= box[3]) lo = mid + 1;
+            else hi = mid;
+        }
+        const result = [];
+        for (let i = 0; i < lo; i++) {
+            const other = sorted[i].box;
+            if (other[3] < box[0] || other[1] > box[4] || other[4] < box[1] || other[2] > box[5] || other[5] < box[2]) continue;
+            result.push(sorted[i]);
+        }
+        return result;
+    }
+
+    // Only the added curves are sorted; they are then merged in, so a single add costs one pass over the index
+    with(added: readonly BoxedCurve[]): CurveIndex {
+        const { sorted } = this;
+        const adding = [...added].sort((a, b) => a.box[0] - b.box[0]);
+        const merged = new Array<BoxedCurve>(sorted.length + adding.length);
+        let i = 0, j = 0, k = 0;
+        while (i < sorted.length && j < adding.length) {
+            merged[k++] = sorted[i].box[0] <= adding[j].box[0] ? sorted[i++] : adding[j++];
+        }
+        while (i < sorted.length) merged[k++] = sorted[i++];
+        while (j < adding.length) merged[k++] = adding[j++];
+        return new CurveIndex(merged);
+    }
+
+    without(id: c3d.SimpleName): CurveIndex {
+        return new CurveIndex(this.sorted.filter(c => c.id !== id));
+    }
+}
+
 export class CrossPointDatabase implements MementoOriginator<CrossPointMemento> {
     private readonly curve2touched = new Map<c3d.SimpleName, ReadonlySet<c3d.SimpleName>>();
     private readonly id2cross = new Map<c3d.SimpleName, ReadonlySet<CrossPoint>>();
@@ -10,68 +63,116 @@ export class CrossPointDatabase implements MementoOriginator<CrossPointMemento>
     private readonly _crosses: Set<CrossPoint> = new Set();
     get crosses(): ReadonlySet<CrossPoint> { return this._crosses }
 
+    private _index?: CurveIndex;
+    private get index() {
+        return this._index ??= new CurveIndex([...this.id2curve].map(([id, curve]) => boxed(id, curve)));
+    }
+
     constructor(other?: CrossPointDatabase) {
         if (other !== undefined) {
             this.restoreFromMemento(other.saveToMemento());
+            this._index = other._index;
         }
     }
 
-    add(id: c3d.SimpleName, curve: c3d.Curve3D) {
-        const { curve2touched, _crosses: allCrosses, id2cross } = this;
-        const { crosses: newCrosses, touched } = this.calculate(id, curve);
+    add(id: c3d.SimpleName, curve: c3d.Curve3D): Set<CrossPoint> {
+        const added = boxed(id, curve);
+        const others = this.index.overlapping(added.box);
+        const result = c3d.CurveIntersection.Intersect([curve], others.map(({ curve }) => curve), mEps);
+        return this.insert([added], others, result);
+    }
+
+    // Curves added within the same tick (say, by an import) are intersected with each other and with the rest in one
+    // native call, off the main thread. Their crosses appear once the returned promise resolves; if the intersection
+    // fails, the promise rejects and, as with add, none of the batch's curves are added.
+    private pending: BoxedCurve[] = [];
+    private readonly queued = new Set<c3d.SimpleName>();
+    private scheduled?: Promise<void>;
+    private running: Promise<void> = Promise.resolve();
 
-        this.id2curve.set(id, curve);
-        id2cross.set(id, new Set());
-        curve2touched.set(id, touched);
-        for (const touchee of touched) {
-            const orig = curve2touched.get(touchee)!;
-            const other = new Set(orig);
-            other.add(id);
-            // updating the touched curves is copy-on-write to allow for nesting CrossPointDatabases
-            curve2touched.set(touchee, other);
+    addAsync(id: c3d.SimpleName, curve: c3d.Curve3D): Promise<void> {
+        this.pending.push(boxed(id, curve));
+        this.queued.add(id);
+        if (this.scheduled === undefined) {
+            this.scheduled = this.running
+                .then(() => new Promise(resolve => setTimeout(resolve)))
+                .then(() => {
+                    this.scheduled = undefined;
+                    const batch = this.pending;
+                    this.pending = [];
+                    return this.flush(batch);
+                });
+            // A failed batch rejects for its own callers only; the next one still runs after it
+            this.running = this.scheduled.catch(() => { });
         }
+        return this.scheduled;
+    }
 
-        for (const cross of newCrosses) {
-            const orig1 = new Set(id2cross.get(cross.on1.id));
-            orig1.add(cross);
-            id2cross.set(cross.on1.id, orig1);
+    private async flush(batch: BoxedCurve[]) {
+        batch = batch.filter(({ id }) => this.queued.has(id));
+        if (batch.length === 0) return;
 
-            const orig2 = new Set(id2cross.get(cross.on2.id));
-            orig2.add(cross);
-            id2cross.set(cross.on2.id, orig2);
-            
-            allCrosses.add(cross);
+        const others = new Set<BoxedCurve>();
+        for (const { box } of batch) {
+            for (const other of this.index.overlapping(box)) others.add(other);
+        }
+        const candidates = [...others];
+        try {
+            const result = await c3d.CurveIntersection.Intersect_async(batch.map(({ curve }) => curve), candidates.map(({ curve }) => curve), mEps);
+            // NOTE: curves removed while intersecting are dropped, as are their crosses
+            this.insert(batch.filter(({ id }) => this.queued.has(id)), candidates, result, batch);
+        } finally {
+            for (const { id } of batch) this.queued.delete(id);
         }
-        return newCrosses;
     }
 
-    private calculate(name: c3d.SimpleName, curve: c3d.Curve3D): { crosses: Set<CrossPoint>, touched: Set<c3d.SimpleName> } {
-        const { allCurves } = this;
-        const touched = new Set<c3d.SimpleName>();
-
-        const crosses = new Set<CrossPoint>();
-        for (const { id: otherName, curve: other } of allCurves) {
-            const { count, result1, result2 } = c3d.ActionPoint.CurveCurveIntersection3D(curve, other, 10e-3,)
-            if (count > 0) {
-                touched.add(otherName);
-                for (let i = 0; i < count; i++) {
-                    const position = curve.PointOn(result1[i]);
-                    const cross = new CrossPoint(
-                        point2point(position),
-                        new PointOnCurve(name, result1[i], curve.GetTMin(), curve.GetTMax()),
-                        new PointOnCurve(otherName, result2[i], other.GetTMin(), other.GetTMax()));
-                    crosses.add(cross);
-                }
-            }
+    // pairs index into added (or into intersected, if given, when some of it has since been dropped), then into others
+    private insert(added: BoxedCurve[], others: BoxedCurve[], { pairs, params }: c3d.PackedCrossPoints, intersected = added): Set<CrossPoint> {
+        const { curve2touched, _crosses: allCrosses, id2cross, id2curve } = this;
+
+        for (const { id, curve } of added) {
+            id2curve.set(id, curve);
+            id2cross.set(id, new Set());
+            curve2touched.set(id, new Set());
         }
-        return { crosses, touched };
-    }
+        this._index = this.index.with(added);
+
+        const all = [...intersected, ...others];
+        const newCrosses = new Set<CrossPoint>();
+        for (let i = 0; i < pairs.length / 2; i++) {
+            const on1 = all[pairs[2 * i]], on2 = all[pairs[2 * i + 1]];
+            if (id2curve.get(on1.id) !== on1.curve || id2curve.get(on2.id) !== on2.curve) continue;
 
-    private get allCurves() {
-        return [...this.id2curve.entries()].map(([id, curve]) => { return { id, curve } });
+            const position = on1.curve.PointOn(params[2 * i]);
+            const cross = new CrossPoint(
+                point2point(position),
+                new PointOnCurve(on1.id, params[2 * i], on1.curve.GetTMin(), on1.curve.GetTMax()),
+                new PointOnCurve(on2.id, params[2 * i + 1], on2.curve.GetTMin(), on2.curve.GetTMax()));
+
+            // updating the touched curves and their crosses is copy-on-write to allow for nesting CrossPointDatabases
+            const touched1 = new Set(curve2touched.get(on1.id));
+            touched1.add(on2.id);
+            curve2touched.set(on1.id, touched1);
+            const touched2 = new Set(curve2touched.get(on2.id));
+            touched2.add(on1.id);
+            curve2touched.set(on2.id, touched2);
+
+            const orig1 = new Set(id2cross.get(on1.id));
+            orig1.add(cross);
+            id2cross.set(on1.id, orig1);
+
+            const orig2 = new Set(id2cross.get(on2.id));
+            orig2.add(cross);
+            id2cross.set(on2.id, orig2);
+
+            allCrosses.add(cross);
+            newCrosses.add(cross);
+        }
+        return newCrosses;
     }
 
     remove(id: c3d.SimpleName) {
+        this.queued.delete(id);
         const data = this.cascade(id);
 
         const readd = new Map<c3d.SimpleName, c3d.Curve3D>();
@@ -113,7 +214,7 @@ export class CrossPointDatabase implements MementoOriginator<CrossPointMemento>
 
     private removeInfo(id: c3d.SimpleName) {
         const { curve2touched, id2curve, id2cross, _crosses: crosses } = this;
-        id2curve.delete(id);
+        if (id2curve.delete(id)) this._index = this.index.without(id);
         curve2touched.delete(id);
         const invalidatedCrosses = id2cross.get(id)!;
         if (invalidatedCrosses === undefined) return;
@@ -146,6 +247,7 @@ export class CrossPointDatabase implements MementoOriginator<CrossPointMemento>
         (this.id2cross as CrossPointDatabase['id2cross']) = new Map(m.id2cross);
         (this.id2curve as CrossPointDatabase['id2curve']) = new Map(m.id2curve);
         (this._crosses as CrossPointDatabase['crosses']) = new Set(m.crosses);
+        this._index = undefined;
     }
 
     clear() {
@@ -153,6 +255,9 @@ export class CrossPointDatabase implements MementoOriginator<CrossPointMemento>
         this.id2cross.clear();
         this.id2curve.clear();
         this._crosses.clear();
+        this._index = undefined;
+        this.pending = [];
+        this.queued.clear();
     }
 
     debug(): void { }
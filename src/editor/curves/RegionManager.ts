@@ -34,9 +34,7 @@ export class RegionManager {
             const { contours } = c3d.ContourGraph.OuterContoursBuilder(decontour);
 
             const regions = c3d.ActionRegion.GetCorrectRegions(contours, false);
-            for (const region of regions) {
-                this.db.addItem(new c3d.PlaneInstance(region, placement), 'automatic');
-            }
+            if (regions.length > 0) this.db.addRegions(regions, placement, 'automatic');
         });
     }
 
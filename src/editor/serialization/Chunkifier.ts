@@ -6,14 +6,16 @@ export class Chunkifier {
         private readonly version: number,
         private readonly json: PlasticityJSON,
         private readonly c3d: Buffer,
+        private readonly tessellation?: Buffer,
     ) {
     }
 
     serialize(): Buffer {
-        const { magic, version, json, c3d } = this;
+        const { magic, version, json, c3d, tessellation } = this;
         const string = Buffer.from(JSON.stringify(json), 'utf-8');
         const header = Buffer.alloc(10 + 4 + 4);
-        const length = header.length + 4 + 4 + string.length + 4 + 4 + c3d.length;
+        let length = header.length + 4 + 4 + string.length + 4 + 4 + c3d.length;
+        if (tessellation !== undefined) length += 4 + 4 + tessellation.length;
         let offset = 0;
         header.write(magic, 'ascii'); offset += 10;
         header.writeUint32LE(version, offset); offset += 4;
@@ -33,10 +35,20 @@ export class Chunkifier {
             c3dChunk.writeUint32LE(0x004e4942 /* BIN */, offset); offset += 4;
             c3d.copy(c3dChunk, offset);
         }
-        return Buffer.concat([header, jsonChunk, c3dChunk]);
+        const chunks = [header, jsonChunk, c3dChunk];
+        // NOTE: the optional third chunk is a cache of face grids (see TessellationCache.Save); readers that don't know it ignore it
+        if (tessellation !== undefined) {
+            const tessellationChunk = Buffer.alloc(4 + 4 + tessellation.length);
+            let offset = 0;
+            tessellationChunk.writeUint32LE(tessellation.length, offset); offset += 4;
+            tessellationChunk.writeUint32LE(0x53534554 /* TESS */, offset); offset += 4;
+            tessellation.copy(tessellationChunk, offset);
+            chunks.push(tessellationChunk);
+        }
+        return Buffer.concat(chunks);
     }
 
-    static load(from: Buffer): { json: PlasticityJSON; c3d: Buffer; } {
+    static load(from: Buffer): { json: PlasticityJSON; c3d: Buffer; tessellation?: Buffer } {
         let offset = 0;
         const magic = from.toString('utf-8', offset, 10); offset += 10;
         if (magic !== 'plasticity') throw new Error('invalid file header');
@@ -57,9 +69,17 @@ export class Chunkifier {
             const length = from.readUint32LE(offset); offset += 4;
             const magic = from.readUint32LE(offset); offset += 4;
             if (magic !== 0x004e4942) throw new Error('invalid magic number');
-            c3d = from.slice(offset, length); offset += length;
+            c3d = from.slice(offset, offset + length); offset += length;
+        }
+        let tessellation: Buffer | undefined;
+        TESS: {
+            if (offset === from.length) break TESS;
+            const length = from.readUint32LE(offset); offset += 4;
+            const magic = from.readUint32LE(offset); offset += 4;
+            if (magic !== 0x53534554) throw new Error('invalid magic number');
+            tessellation = from.slice(offset, offset + length); offset += length;
         }
-        return { json, c3d };
+        return { json, c3d, tessellation };
     }
 }
 
@@ -220,7 +220,8 @@ export class SnapManager implements MementoOriginator<SnapMemento> {
     private addInstance(view: visual.SpaceInstance<visual.Curve3D>, into: Set<Snap>) {
         const inst = this.db.lookup(view);
         const item = inst2curve(inst)!;
-        this.crosses.add(view.simpleName, item);
+        // NOTE: curves added together, as by an import, are intersected in one batch, off the main thread
+        this.crosses.addAsync(view.simpleName, item);
         const curveSnap = this.identityMap.CurveSnap(view, item);
         this.addCurve(curveSnap, item, item, into);
     }
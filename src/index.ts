@@ -80,6 +80,12 @@ ipcMain.handle('show-save-dialog', async (event, args) => {
     return dialog.showSaveDialog(args);
 });
 
+// A fraction between 0 and 1 shows in the taskbar/dock; a negative one removes the bar
+ipcMain.on('set-progress', (event, fraction: number) => {
+    const window = BrowserWindow.fromWebContents(event.sender)!;
+    window.setProgressBar(fraction);
+});
+
 ipcMain.on('window-event', (event, eventName: String) => {
     const window = BrowserWindow.fromWebContents(event.sender)!;
 
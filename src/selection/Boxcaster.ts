@@ -21,7 +21,8 @@ export class Boxcaster {
     readonly startPoint = new THREE.Vector3();
     readonly endPoint = new THREE.Vector3();
     readonly frustum = new THREE.Frustum();
-    private mode: 'contains' | 'intersects' = 'contains';
+    private _mode: 'contains' | 'intersects' = 'contains';
+    get mode() { return this._mode }
     private readonly deep = Number.MAX_VALUE;
 
     constructor(private readonly camera: CameraLike, public layers: ReadonlyLayers = new THREE.Layers()) {
@@ -45,9 +46,9 @@ export class Boxcaster {
     }
 
     selectGeometry(object: Boxcastable, selected: Boxcastable[]) {
-        if (this.mode == 'contains' && object.containsGeometry(this)) {
+        if (this._mode == 'contains' && object.containsGeometry(this)) {
             selected.push(object);
-        } else if (this.mode == 'intersects' && object.intersectsGeometry(this)) {
+        } else if (this._mode == 'intersects' && object.intersectsGeometry(this)) {
             selected.push(object);
         }
     }
@@ -55,7 +56,7 @@ export class Boxcaster {
     updateFrustum() {
         const { startPoint, endPoint } = this;
 
-        this.mode = endPoint.x < startPoint.x ? 'intersects' : 'contains';
+        this._mode = endPoint.x < startPoint.x ? 'intersects' : 'contains';
 
         // Avoid invalid frustum
         if (startPoint.x === endPoint.x) endPoint.x += Number.EPSILON;
@@ -89,6 +89,20 @@ export function mat2mat(mat: THREE.Matrix4 | c3d.Matrix3D, into?: THREE.Matrix4
     }
 }
 
+// minSag and maxSag are in model units, like the precisions given to StepData
+export function camera2viewCamera(camera: THREE.PerspectiveCamera | THREE.OrthographicCamera, viewportHeight: number, pixelError: number, minSag: number, maxSag: number): c3d.ViewCamera {
+    camera.updateMatrixWorld();
+    const eye = camera.getWorldPosition(new THREE.Vector3()).multiplyScalar(unit(1));
+    const direction = camera.getWorldDirection(new THREE.Vector3());
+    const result = { eye: eye.toArray(), direction: direction.toArray(), fov: 0, height: 0, viewportHeight, pixelError, minSag, maxSag };
+    if (camera instanceof THREE.PerspectiveCamera) {
+        result.fov = deg2rad(camera.getEffectiveFOV());
+    } else {
+        result.height = unit((camera.top - camera.bottom) / camera.zoom);
+    }
+    return result;
+}
+
 export function inst2curve(instance: c3d.Item): c3d.Curve3D | undefined {
     if (!(instance instanceof c3d.SpaceInstance)) return;
     const item = instance.GetSpaceItem()!;
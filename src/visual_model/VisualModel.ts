@@ -427,6 +427,16 @@ export class CurveGroup<T extends CurveEdge | CurveSegment> extends THREE.Group
     get line() { return this.mesh.children[0] as LineSegments2 }
     get occludedLine() { return this.mesh.children[1] as LineSegments2 }
 
+    private _bvh?: c3d.MeshBVH;
+    get bvh(): c3d.MeshBVH {
+        if (this._bvh === undefined) {
+            const instanceStart = this.line.geometry.attributes.instanceStart as THREE.InterleavedBufferAttribute;
+            const array = instanceStart.data.array as Float32Array;
+            this._bvh = new c3d.MeshBVH([], this.edges.map(({ group }) => array.subarray(group.start, group.start + group.count)));
+        }
+        return this._bvh;
+    }
+
     get parentItem(): Solid {
         const result = this.parent?.parent?.parent;
         if (!(result instanceof Solid)) {
@@ -489,6 +499,12 @@ export class FaceGroup extends THREE.Group {
         const index = this.mesh.geometry.index!;
         return { start: 0, count: index.count }
     }
+
+    private _bvh?: c3d.MeshBVH;
+    get bvh(): c3d.MeshBVH {
+        if (this._bvh === undefined) this._bvh = new c3d.MeshBVH(this.faces.map(face => face.grid));
+        return this._bvh;
+    }
 }
 
 export class ControlPointGroup extends THREE.Object3D {
@@ -55,7 +55,12 @@ Solids: {
         if (type == 'contained') {
             for (const face of this) selects.push(face);
         } else if (type == 'intersected') {
-            boxcaster.selectObjects([...this], selects);
+            // NOTE: rather than testing face by face, one query against a BVH of all the faces' triangles
+            const { faces } = this.bvh.Boxcast(localPlanes(boxcaster, this.mesh.matrixWorld), boxcaster.mode == 'contains');
+            for (const i of faces) {
+                const face = this.faces[i];
+                if (boxcaster.layers.test(face.layers)) selects.push(face);
+            }
         }
     }
 
@@ -160,7 +165,11 @@ Solids: {
                 selects.push(element);
             }
         } else if (type == 'intersected') {
-            boxcaster.selectObjects([...this], selects);
+            const { edges } = this.bvh.Boxcast(localPlanes(boxcaster, this.line.matrixWorld), boxcaster.mode == 'contains');
+            for (const i of edges) {
+                const edge = this.get(i);
+                if (boxcaster.layers.test(edge.layers)) selects.push(edge);
+            }
         }
     }
 
@@ -526,6 +535,19 @@ Empties: {
     }
 }
 
+// The frustum in the object's local space, packed as the native Boxcast expects
+function localPlanes(boxcaster: Boxcaster, matrixWorld: THREE.Matrix4) {
+    _frustum.copy(boxcaster.frustum);
+    _inverseMatrix.copy(matrixWorld).invert();
+    _frustum.applyMatrix4(_inverseMatrix);
+    for (let i = 0; i < 6; i++) {
+        const plane = _frustum.planes[i];
+        plane.normal.toArray(_planes, 4 * i);
+        _planes[4 * i + 3] = plane.constant;
+    }
+    return _planes;
+}
+
 function intersectsGeometry(boxcaster: Boxcaster, geometry: THREE.BufferGeometry, matrixWorld: THREE.Matrix4, start: number, end: number) {
     const index = geometry.index!;
     const position = geometry.attributes.position;
@@ -623,6 +645,7 @@ const _i = new THREE.Vector3();
 const _inverseMatrix = new THREE.Matrix4();
 const _box = new THREE.Box3();
 const _line = new THREE.Line3();
+const _planes = new Float32Array(24);
 
 const _points = [
     new THREE.Vector3(),
@@ -97,7 +97,8 @@ export class FaceGroupBuilder {
 
     build(topologyModel?: GeometryDatabase['topologyModel']): FaceGroup {
         const { grids, materials, userDatas } = this;
-        const merged = mergeBufferGeometries(grids);
+        // NOTE: the grids are packed natively into one ArrayBuffer, rather than merged here face by face
+        const merged = packedBufferGeometry(c3d.MeshBufferPool.Pack(grids));
         const groups = merged.groups;
 
         const mesh = new THREE.Mesh(merged, materials[0]);
@@ -110,6 +111,9 @@ export class FaceGroupBuilder {
 
             const model = grid.model;
             const face = new Face(group, grid.grid, userData);
+            // NOTE: saves a native GetCube() per face when raycasting
+            const { bounds } = grid;
+            if (bounds !== undefined) face.boundingBox = new THREE.Box3(new THREE.Vector3(bounds[0], bounds[1], bounds[2]), new THREE.Vector3(bounds[3], bounds[4], bounds[5]));
             faces.push(face);
 
             if (topologyModel !== undefined) {
@@ -144,7 +148,7 @@ export type LineInfo = {
     model: c3d.CurveEdge;
 };
 
-abstract class CurveBuilder<T extends CurveEdge | CurveSegment> {
+export abstract class CurveBuilder<T extends CurveEdge | CurveSegment> {
     private readonly lines: LineInfo[] = [];
 
     add(edge: c3d.EdgeBuffer, parentId: c3d.SimpleName, material: LineMaterial, occludedMaterial: LineMaterial) {
@@ -237,6 +241,35 @@ abstract class CurveBuilder<T extends CurveEdge | CurveSegment> {
 
         return { geometry, array, groups };
     }
+
+    // Same as mergePositions, but for polylines packed by Mesh.GetPackedEdges; offsets are in points.
+    static mergePackedPositions(position: Float32Array, offsets: Uint32Array) {
+        const groups: GeometryGroup[] = [];
+        const polylines = offsets.length - 1;
+        let arrayLength = 0;
+        for (let k = 0; k < polylines; k++) {
+            arrayLength += Math.max(0, offsets[k + 1] - offsets[k] - 1) * 6;
+        }
+        const array = new Float32Array(arrayLength);
+        let offset = 0;
+        for (let k = 0; k < polylines; k++) {
+            const from = offsets[k] * 3, to = offsets[k + 1] * 3;
+            for (let j = from; j + 3 < to; j += 3, offset += 6) {
+                array[offset + 0] = position[j + 0];
+                array[offset + 1] = position[j + 1];
+                array[offset + 2] = position[j + 2];
+                array[offset + 3] = position[j + 3];
+                array[offset + 4] = position[j + 4];
+                array[offset + 5] = position[j + 5];
+            }
+            const length = Math.max(0, to - from - 3) * 2;
+            groups.push({ start: offset - length, count: length, materialIndex: k });
+        }
+        const geometry = new LineSegmentsGeometry();
+        geometry.setPositions(array);
+
+        return { geometry, array, groups };
+    }
 }
 
 export class CurveEdgeGroupBuilder extends CurveBuilder<CurveEdge> {
@@ -331,6 +364,22 @@ export function mergeBufferGeometries(grids: c3d.MeshBuffer[]) {
     return mergedGeometry;
 }
 
+// Number of entries per grid in c3d.PackedMeshBuffer#groups: start, count, i, style, simpleName
+export const PackedGroupStride = 5;
+
+// Unlike mergeBufferGeometries, the buffers are already merged natively, so this just wraps them
+export function packedBufferGeometry(packed: c3d.PackedMeshBuffer) {
+    const { index, position, normal, groups } = packed;
+    const geometry = new THREE.BufferGeometry();
+    for (let g = 0, i = 0; g < groups.length; g += PackedGroupStride, i++) {
+        geometry.addGroup(groups[g + 0], groups[g + 1], i);
+    }
+    geometry.setIndex(new THREE.BufferAttribute(index, 1));
+    geometry.setAttribute('position', new THREE.BufferAttribute(position, 3));
+    geometry.setAttribute('normal', new THREE.BufferAttribute(normal, 3));
+    return geometry;
+}
+
 export function mergeBufferAttributes(attributes: Float32Array[]) {
     let arrayLength = 0;
     for (const attribute of attributes) arrayLength += attribute.length;
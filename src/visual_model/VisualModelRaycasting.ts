@@ -61,11 +61,31 @@ Solids: {
             if (!_ray.intersectsBox(geometry.boundingBox)) return;
         }
 
-        const objects = [...this];
-        for (const object of objects) {
-            if (object.layers.test(raycaster.layers)) {
-                raycastableTopologyItem.topologyItem = object;
-                raycastableTopologyItem.raycast(raycaster, intersects);
+        // NOTE: rather than a native call per face, one query against a BVH of all the faces' triangles, built on first use.
+        // Only the nearest hit within near..far is reported, so the BVH must skip whatever is closer than near itself.
+        _ray.origin.toArray(_rays, 0);
+        _ray.direction.toArray(_rays, 3);
+        const scale = _v1.copy(_ray.direction).applyMatrix3(_matrix3.setFromMatrix4(matrixWorld)).length(); // world units per local unit along the ray
+        const { faces, point } = this.bvh.Raycast(_rays, raycaster.near / scale, raycaster.far / scale);
+        if (faces[0] < 0) return;
+
+        const face = this.faces[faces[0]];
+        if (face.layers.test(raycaster.layers)) {
+            const p = new THREE.Vector3().fromArray(point).applyMatrix4(matrixWorld);
+            intersects.push({
+                object: raycastableTopologyItem,
+                distance: raycaster.ray.origin.distanceTo(p),
+                point: p,
+                // @ts-expect-error
+                topologyItem: face,
+            });
+        } else {
+            // The nearest face is filtered out, so whatever is behind it could be hit instead
+            for (const object of this) {
+                if (object.layers.test(raycaster.layers)) {
+                    raycastableTopologyItem.topologyItem = object;
+                    raycastableTopologyItem.raycast(raycaster, intersects);
+                }
             }
         }
 
@@ -394,7 +414,9 @@ function getWorldSpaceHalfWidth(camera: THREE.Camera, distance: number, lineWidt
 }
 
 const _inverseMatrix = new THREE.Matrix4();
+const _matrix3 = new THREE.Matrix3();
 const _ray = new THREE.Ray();
+const _rays = new Float32Array(6);
 const _sphere = new THREE.Sphere();
 const _v1 = new THREE.Vector3();
 const _clipToWorldVector = new THREE.Vector4();